@@ -3,8 +3,38 @@
 #define _CRT_SECURE_NO_WARNINGS
 #endif // !_CRT_SECURE_NO_WARNINGS
 #include <diesel.h>
+#include <stddef.h>
+#include <type_traits>
 
-enum TweakableType { ST_FLOAT, ST_INT, ST_UINT, ST_VEC2, ST_VEC3, ST_VEC4, ST_COLOR, ST_ARRAY, ST_NONE };
+enum TweakableType { ST_FLOAT, ST_INT, ST_UINT, ST_VEC2, ST_VEC3, ST_VEC4, ST_COLOR, ST_ARRAY, ST_CURVE, ST_NONE };
+
+// -------------------------------------------------------
+// curves
+// The keys are written in the file sorted by t, linear
+// curves as "t, value" pairs and Hermite curves as
+// "t, value, tangent" triples. Every load bakes the keys
+// into a table of TWK_CURVE_RESOLUTION samples between the
+// first and the last key so evaluating is one table lookup.
+// Outside of the keys the curve is clamped.
+// -------------------------------------------------------
+#ifndef TWK_CURVE_RESOLUTION
+#define TWK_CURVE_RESOLUTION 128
+#endif
+#ifndef TWK_CURVE_MAX_KEYS
+#define TWK_CURVE_MAX_KEYS 16
+#endif
+
+enum TwkCurveMode { TWK_CURVE_LINEAR, TWK_CURVE_HERMITE };
+
+struct TwkCurve {
+	float start;
+	float scale;
+	// the last sample is repeated so evaluating needs no extra check
+	float table[TWK_CURVE_RESOLUTION + 1];
+	int mode;
+	int count;
+	float keys[TWK_CURVE_MAX_KEYS * 3];
+};
 
 struct Tweakable {
 	TweakableType type;
@@ -18,961 +48,6729 @@ struct Tweakable {
 		ds::vec4* v4Ptr;
 		ds::Color* cPtr;
 		float* arPtr;
+		TwkCurve* curvePtr;
 	} ptr;
 	int arrayLength;
 };
 
-typedef void(*twkErrorHandler)(const char* errorMessage);
-
-void twk_init(twkErrorHandler = 0);
-
-void twk_init(const char* fileName, twkErrorHandler = 0);
-
-void twk_add(const char* category, const char* name, int* value);
-
-void twk_add(const char* category, const char* name, uint32_t* value);
+// -------------------------------------------------------
+// compile time hashed keys
+// TWK_KEY("sparkle", "gap") hashes both strings while
+// compiling so the key overloads of twk_add and twk_get do
+// no string hashing at runtime.
+// -------------------------------------------------------
+struct TwkKey {
+	const char* category;
+	const char* name;
+	uint32_t categoryHash;
+	uint32_t nameHash;
+};
 
-void twk_add(const char* category, const char* name, float* value);
+constexpr uint32_t twk_fnv1a_const(const char* text, uint32_t hash = 0x811C9DC5) {
+	return *text == 0 ? hash : twk_fnv1a_const(text + 1, (static_cast<uint32_t>(static_cast<unsigned char>(*text)) ^ hash) * 0x01000193);
+}
 
-void twk_add(const char* category, const char* name, ds::vec2* value);
+#define TWK_KEY(category, name) TwkKey{ category, name, std::integral_constant<uint32_t, twk_fnv1a_const(category)>::value, std::integral_constant<uint32_t, twk_fnv1a_const(name)>::value }
 
-void twk_add(const char* category, const char* name, ds::vec3* value);
+// -------------------------------------------------------
+// typed handle returned by twk_add
+// The handle stays valid until twk_shutdown and gives O(1)
+// access without any string work.
+// -------------------------------------------------------
+template<class T>
+struct TwkHandle {
+	int index;
+};
 
-void twk_add(const char* category, const char* name, ds::vec4* value);
+// -------------------------------------------------------
+// field descriptor for registering whole structs
+// TWK_FIELD(SparkleSettings, startScale, "start_scale")
+// derives the offset and the type of the member.
+// -------------------------------------------------------
+struct TwkField {
+	const char* name;
+	size_t offset;
+	TweakableType type;
+	int arrayLength;
+};
 
-void twk_add(const char* category, const char* name, ds::Color* value);
+template<class T> struct TwkFieldType;
+template<> struct TwkFieldType<int> { static const TweakableType type = ST_INT; static const int length = 0; };
+template<> struct TwkFieldType<uint32_t> { static const TweakableType type = ST_UINT; static const int length = 0; };
+template<> struct TwkFieldType<float> { static const TweakableType type = ST_FLOAT; static const int length = 0; };
+template<> struct TwkFieldType<ds::vec2> { static const TweakableType type = ST_VEC2; static const int length = 0; };
+template<> struct TwkFieldType<ds::vec3> { static const TweakableType type = ST_VEC3; static const int length = 0; };
+template<> struct TwkFieldType<ds::vec4> { static const TweakableType type = ST_VEC4; static const int length = 0; };
+template<> struct TwkFieldType<ds::Color> { static const TweakableType type = ST_COLOR; static const int length = 0; };
+template<size_t N> struct TwkFieldType<float[N]> { static const TweakableType type = ST_ARRAY; static const int length = static_cast<int>(N); };
 
-void twk_add(const char* category, const char* name, float* array,int size);
+#define TWK_FIELD(structType, member, name) { name, offsetof(structType, member), TwkFieldType<decltype(((structType*)0)->member)>::type, TwkFieldType<decltype(((structType*)0)->member)>::length }
 
-int twk_num_categories();
+typedef void(*twkErrorHandler)(const char* errorMessage);
 
-const char* twk_get_category_name(int index);
+struct TWKContext;
 
-int twk_get_tweakables(int categoryIndex, Tweakable* ret, int max);
+typedef void(*twkChangeCallback)(const char* category, const char* name, void* user);
 
-int twk_get_tweakables(const char* category, Tweakable* ret, int max);
+// -------------------------------------------------------
+// allocator hooks - every allocation of the library goes
+// through alloc and free. alloc may return 0 if it is out
+// of memory, the block is then taken from the heap.
+// -------------------------------------------------------
+typedef void*(*twkAllocFunc)(size_t size, void* user);
 
-void twk_shutdown();
+typedef void(*twkFreeFunc)(void* ptr, void* user);
 
-bool twk_load();
+struct TwkAllocator {
+	twkAllocFunc alloc;
+	twkFreeFunc free;
+	void* user;
+};
 
-void twk_parse(const char* text);
+struct TwkAllocationStats {
+	size_t allocations;
+	size_t frees;
+	size_t bytesInUse;
+	size_t peakBytes;
+	size_t heapFallbacks;
+};
 
-bool twk_verify();
+void twk_init(twkErrorHandler = 0);
 
-void twk_save();
+void twk_init(const char* fileName, twkErrorHandler = 0);
 
-//#define GAMESETTINGS_IMPLEMENTATION
+void twk_init(const TwkAllocator& allocator, twkErrorHandler = 0);
 
-#ifdef GAMESETTINGS_IMPLEMENTATION
+void twk_init(const char* fileName, const TwkAllocator& allocator, twkErrorHandler = 0);
 
-#include <Windows.h>
-#include <vector>
+TwkAllocator twk_arena_allocator(void* memory, size_t capacity);
 
+void twk_get_allocation_stats(TwkAllocationStats* stats);
 
 // -------------------------------------------------------
-// game settings item
+// reload statistics - all times are in microseconds. The
+// histograms use power of two buckets, bucket i counts the
+// reloads that took less than 2^i microseconds and the last
+// bucket everything above.
 // -------------------------------------------------------
+#define TWK_STATS_BUCKETS 24
 
-struct TWKCategory {
-	uint32_t hash;
-	uint16_t nameIndex;
+struct TwkHistogram {
+	uint32_t buckets[TWK_STATS_BUCKETS];
+	uint32_t count;
+	double sum;
+	double max;
 };
 
-struct InternalTweakable {
-
-	size_t categoryIndex;
-	uint32_t hash;
-	TweakableType type;
-	int nameIndex;
-	int length;
-	union {
-		int* iPtr;
-		uint32_t* uiPtr;
-		float* fPtr;
-		ds::vec2* v2Ptr;
-		ds::vec3* v3Ptr;
-		ds::vec4* v4Ptr;
-		ds::Color* cPtr;
-		float* arPtr;
-	} ptr;
-	int arrayLength;
-	bool found;
+struct TwkReloadStats {
+	size_t bytesRead;
+	uint32_t tokens;
+	uint32_t keysApplied;
+	uint32_t lookupProbes;
+	uint32_t lookupMisses;
+	uint32_t derivedEvaluated;
+	size_t allocations;
+	double loadTime;
+	double parseTime;
+	double applyTime;
+	double totalTime;
 };
 
-// -------------------------------------------------------
-// internal char buffer
-// -------------------------------------------------------
-struct InternalCharBuffer {
-	char* data;
-	size_t capacity;
-	size_t size;
-	int count;
-	size_t* indices;
-	size_t* sizes;
-	uint32_t* hashes;
-	size_t indexCapacity;
+struct TwkStats {
+	TwkReloadStats last;
+	uint32_t reloads;
+	TwkHistogram load;
+	TwkHistogram parse;
+	TwkHistogram apply;
+	TwkHistogram total;
 };
 
-// -------------------------------------------------------
-// internal settings context
-// -------------------------------------------------------
-struct TWKContext {
-	const char* fileName;
-	FILETIME filetime;
-	std::vector<InternalTweakable> items;
-	std::vector<TWKCategory> categories;
-	bool loaded;
-	bool reloadable;
-	InternalCharBuffer charBuffer;
-	twkErrorHandler errorHandler;
-};
+TwkStats twk_stats();
 
-static TWKContext* _twkCtx = 0;
+void twk_enable_trace(int maxEvents = 4096);
 
-// -------------------------------------------------------
-// init
-// -------------------------------------------------------
-static void twk__common_init(twkErrorHandler errorHandler) {
-	_twkCtx->charBuffer.data = 0;
-	_twkCtx->charBuffer.capacity = 0;
-	_twkCtx->charBuffer.count = 0;
-	_twkCtx->charBuffer.indices = 0;
-	_twkCtx->charBuffer.sizes = 0;
-	_twkCtx->charBuffer.size = 0;
-	_twkCtx->charBuffer.indexCapacity = 0;
-	_twkCtx->charBuffer.hashes = 0;
-	_twkCtx->errorHandler = errorHandler;
-}
+bool twk_write_trace(const char* fileName);
 
-void twk_init(const char* fileName, twkErrorHandler errorHandler) {
-	_twkCtx = new TWKContext;
-	_twkCtx->fileName = fileName;
-	_twkCtx->loaded = false;
-	_twkCtx->reloadable = true;
-	twk__common_init(errorHandler);
-}
+TwkHandle<int> twk_add(const char* category, const char* name, int* value);
 
-void twk_init(twkErrorHandler errorHandler) {
-	_twkCtx = new TWKContext;
-	_twkCtx->fileName = '\0';
-	_twkCtx->loaded = true;
-	_twkCtx->reloadable = false;
-	twk__common_init(errorHandler);
-}
+TwkHandle<uint32_t> twk_add(const char* category, const char* name, uint32_t* value);
 
+TwkHandle<float> twk_add(const char* category, const char* name, float* value);
 
+TwkHandle<ds::vec2> twk_add(const char* category, const char* name, ds::vec2* value);
 
-// -------------------------------------------------------
-// shutdown
-// -------------------------------------------------------
-void twk_shutdown() {
-	if (_twkCtx != 0) {
-		if (_twkCtx->charBuffer.data != 0) {
-			delete[] _twkCtx->charBuffer.data;
-		}
-		if (_twkCtx->charBuffer.indices != 0) {
-			delete[] _twkCtx->charBuffer.indices;
-		}
-		if (_twkCtx->charBuffer.sizes != 0) {
-			delete[] _twkCtx->charBuffer.sizes;
-		}
-		delete _twkCtx;
-	}
-}
+TwkHandle<ds::vec3> twk_add(const char* category, const char* name, ds::vec3* value);
 
-// -------------------------------------------------------
-// Hashing
-// -------------------------------------------------------
-const uint32_t TWK__FNV_Prime = 0x01000193; 
-const uint32_t TWK__FNV_Seed = 0x811C9DC5;
+TwkHandle<ds::vec4> twk_add(const char* category, const char* name, ds::vec4* value);
 
-inline uint32_t twk_fnv1a(const char* text, uint32_t hash = TWK__FNV_Seed) {
-	const unsigned char* ptr = (const unsigned char*)text;
-	while (*ptr) {
-		hash = (*ptr++ ^ hash) * TWK__FNV_Prime;
-	}
-	return hash;
-}
+TwkHandle<ds::Color> twk_add(const char* category, const char* name, ds::Color* value);
 
-static int twk__find_category(const char* category) {
-	uint32_t categoryHash = twk_fnv1a(category);
-	for (size_t i = 0; i < _twkCtx->categories.size(); ++i) {
-		if (_twkCtx->categories[i].hash == categoryHash) {
-			return static_cast<int>(i);
-		}
-	}
-	return -1;
-}
+TwkHandle<float*> twk_add(const char* category, const char* name, float* array,int size);
 
-// -------------------------------------------------------
-// internal char buffer reallocation
-// -------------------------------------------------------
-static void twk__realloc_char_buffer(InternalCharBuffer* buffer, size_t additional) {
-	if (buffer->data == 0) {
-		buffer->data = new char[additional];
-		buffer->capacity = additional;
-		buffer->indices = new size_t[16];
-		buffer->sizes = new size_t[16];
-		buffer->hashes = new uint32_t[16];
-		buffer->indexCapacity = 16;
-	}
-	else {
-		char* tmp = new char[buffer->capacity + additional];
-		memcpy(tmp, buffer->data, buffer->capacity);
-		buffer->capacity = buffer->capacity + additional;
-		delete[] buffer->data;
-		buffer->data = tmp;
-	}
-}
+TwkHandle<TwkCurve> twk_add(const char* category, const char* name, TwkCurve* curve, TwkCurveMode mode, const float* keys = 0, int count = 0);
 
-// -------------------------------------------------------
-// internal char buffer indices reallocation
-// -------------------------------------------------------
-static void twk__reallocate_indices(InternalCharBuffer* buffer, size_t additional) {
-	size_t* tmpi = new size_t[buffer->indexCapacity + additional];
-	memcpy(tmpi, buffer->indices, buffer->count * sizeof(size_t));
-	delete[] buffer->indices;
-	buffer->indices = tmpi;
-	size_t* tmps = new size_t[buffer->indexCapacity + additional];
-	memcpy(tmps, buffer->sizes, buffer->count * sizeof(size_t));
-	delete[] buffer->sizes;
-	buffer->sizes = tmps;
-	uint32_t* tmph = new uint32_t[buffer->indexCapacity + additional];
-	memcpy(tmph, buffer->hashes, buffer->count * sizeof(uint32_t));
-	delete[] buffer->hashes;
-	buffer->hashes = tmph;
-	buffer->indexCapacity += additional;
-}
+TwkHandle<int> twk_add(const TwkKey& key, int* value);
 
-static int twk__find_string(uint32_t hash) {
-	for (int i = 0; i < _twkCtx->charBuffer.count; ++i) {
-		if (_twkCtx->charBuffer.hashes[i] == hash) {
-			return i;
-		}
-	}
-	return -1;
-}
-// -------------------------------------------------------
-// internal add string to char buffer
-// -------------------------------------------------------
-static int twk__add_string(const char* txt) {
-	uint32_t hash = twk_fnv1a(txt);
-	int strIdx = twk__find_string(hash);
-	if (strIdx != -1) {
-		return strIdx;
-	}
-	size_t l = strlen(txt);
-	if ((l + _twkCtx->charBuffer.size + 1) >= _twkCtx->charBuffer.capacity) {
-		twk__realloc_char_buffer(&_twkCtx->charBuffer, l * 2);
-	}
-	if (_twkCtx->charBuffer.count + 1 >= _twkCtx->charBuffer.indexCapacity) {
-		twk__reallocate_indices(&_twkCtx->charBuffer, 16);
-	}
-	size_t current = _twkCtx->charBuffer.size;
-	char* dest = _twkCtx->charBuffer.data + current;
-	_twkCtx->charBuffer.indices[_twkCtx->charBuffer.count] = current;
-	_twkCtx->charBuffer.sizes[_twkCtx->charBuffer.count] = l + 1;
-	_twkCtx->charBuffer.hashes[_twkCtx->charBuffer.count] = hash;
-	++_twkCtx->charBuffer.count;
-	strncpy(dest, txt, l);
-	_twkCtx->charBuffer.size += l + 1;
-	dest[l] = '\0';
-	return _twkCtx->charBuffer.count - 1;
-}
+TwkHandle<uint32_t> twk_add(const TwkKey& key, uint32_t* value);
 
-static char* twk__get_string(int index) {
-	return _twkCtx->charBuffer.data + _twkCtx->charBuffer.indices[index];
-}
-// -------------------------------------------------------
-// internal add
-// -------------------------------------------------------
-static size_t twk_internal_add(const char* category, const char* name, TweakableType type) {
-	InternalTweakable item;
-	int catIdx = twk__find_category(category);
-	if (catIdx == -1) {
-		TWKCategory cat;
-		cat.hash = twk_fnv1a(category);
-		cat.nameIndex = twk__add_string(category);
-		_twkCtx->categories.push_back(cat);
-		catIdx = static_cast<int>(_twkCtx->categories.size()) - 1;
-	}
-	item.categoryIndex = catIdx;
-	item.hash = twk_fnv1a(name);
-	item.type = type;
-	item.arrayLength = 0;
-	item.found = false;
-	item.nameIndex = twk__add_string(name);
-	_twkCtx->items.push_back(item);
-	return _twkCtx->items.size() - 1;
-}
+TwkHandle<float> twk_add(const TwkKey& key, float* value);
 
-// -------------------------------------------------------
-// add int
-// -------------------------------------------------------
-void twk_add(const char* category, const char* name, int* value) {
-	size_t idx = twk_internal_add(category, name, TweakableType::ST_INT);
-	_twkCtx->items[idx].ptr.iPtr = value;
-}
+TwkHandle<ds::vec2> twk_add(const TwkKey& key, ds::vec2* value);
 
-// -------------------------------------------------------
-// add uint32_t
-// -------------------------------------------------------
-void twk_add(const char* category, const char* name, uint32_t* value) {
-	size_t idx = twk_internal_add(category, name, TweakableType::ST_UINT);
-	_twkCtx->items[idx].ptr.uiPtr = value;
-}
+TwkHandle<ds::vec3> twk_add(const TwkKey& key, ds::vec3* value);
 
-// -------------------------------------------------------
-// add float
-// -------------------------------------------------------
-void twk_add(const char* category, const char* name, float* value) {
-	size_t idx = twk_internal_add(category, name, TweakableType::ST_FLOAT);
-	_twkCtx->items[idx].ptr.fPtr = value;
-}
+TwkHandle<ds::vec4> twk_add(const TwkKey& key, ds::vec4* value);
 
-// -------------------------------------------------------
-// add vec2
-// -------------------------------------------------------
-void twk_add(const char* category, const char* name, ds::vec2* value) {
-	size_t idx = twk_internal_add(category, name, TweakableType::ST_VEC2);
-	_twkCtx->items[idx].ptr.v2Ptr = value;
-}
+TwkHandle<ds::Color> twk_add(const TwkKey& key, ds::Color* value);
 
-// -------------------------------------------------------
-// add vec3
-// -------------------------------------------------------
-void twk_add(const char* category, const char* name, ds::vec3* value) {
-	size_t idx = twk_internal_add(category, name, TweakableType::ST_VEC3);
-	_twkCtx->items[idx].ptr.v3Ptr = value;
-}
+TwkHandle<float*> twk_add(const TwkKey& key, float* array, int size);
 
-// -------------------------------------------------------
-// add vec4
-// -------------------------------------------------------
-void twk_add(const char* category, const char* name, ds::vec4* value) {
-	size_t idx = twk_internal_add(category, name, TweakableType::ST_VEC4);
-	_twkCtx->items[idx].ptr.v4Ptr = value;
-}
+TwkHandle<TwkCurve> twk_add(const TwkKey& key, TwkCurve* curve, TwkCurveMode mode, const float* keys = 0, int count = 0);
 
-// -------------------------------------------------------
-// add color
-// -------------------------------------------------------
-void twk_add(const char* category, const char* name, ds::Color* value) {
-	size_t idx = twk_internal_add(category, name, TweakableType::ST_COLOR);
-	_twkCtx->items[idx].ptr.cPtr = value;
-}
+void twk_add_struct(const char* category, void* instance, const TwkField* fields, int numFields);
 
-// -------------------------------------------------------
-// add array
-// -------------------------------------------------------
-void twk_add(const char* category, const char* name, float* array, int size) {
-	size_t idx = twk_internal_add(category, name, TweakableType::ST_ARRAY);
-	_twkCtx->items[idx].ptr.arPtr = array;
-	_twkCtx->items[idx].arrayLength = size;
-}
+void twk_add_struct(const char* const* categories, int count, void* first, size_t stride, const TwkField* fields, int numFields);
 
-// ------------------------------------------------------------
-// internal error reporting using the twkErrorHandle callback
-// ------------------------------------------------------------
-static void twk__report_error(char* format, ...) {
-	if (_twkCtx->errorHandler != 0) {
-		va_list args;
-		va_start(args, format);
-		char buffer[1024];
-		memset(buffer, 0, sizeof(buffer));
-		int written = vsnprintf_s(buffer, sizeof(buffer), _TRUNCATE, format, args);	
-		(*_twkCtx->errorHandler)(buffer);
-		va_end(args);
-	}
-}
+bool twk_get(const char* category, const char* name, int* value);
 
-bool twk_get(const char* category, const char* name, int* value) {
-	return false;
-}
+bool twk_get(const char* category, const char* name, uint32_t* value);
 
-bool twk_get(const char* category, const char* name, uint32_t* value) {
-	return false;
-}
+bool twk_get(const char* category, const char* name, float* value);
 
-static int twk__find_item(const char* category, const char* name, TweakableType type) {
-	int cidx = twk__find_category(category);
-	if (cidx != -1) {
-		uint32_t hash = twk_fnv1a(name);
-		for (size_t i = 0; i < _twkCtx->items.size(); ++i) {
-			const InternalTweakable& item = _twkCtx->items[i];
-			if (item.categoryIndex == cidx && item.hash == hash && item.type == type) {
-				return i;
-			}
-		}
-	}
-	return -1;
-}
+bool twk_get(const char* category, const char* name, ds::vec2* value);
 
-bool twk_get(const char* category, const char* name, float* value) {
-	int idx = twk__find_item(category, name, TweakableType::ST_FLOAT);
-	if (idx != -1) {
-		const InternalTweakable& item = _twkCtx->items[idx];
-		*value = *item.ptr.fPtr;
-		return true;
-	}
-	return false;
-}
+bool twk_get(const char* category, const char* name, ds::vec3* value);
 
-bool twk_get(const char* category, const char* name, ds::vec2* value) {
-	return false;
-}
+bool twk_get(const char* category, const char* name, ds::vec4* value);
 
-bool twk_get(const char* category, const char* name, ds::vec3* value) {
-	return false;
-}
+bool twk_get(const char* category, const char* name, ds::Color* value);
 
-bool twk_get(const char* category, const char* name, ds::vec4* value) {
-	return false;
-}
+bool twk_get(const char* category, const char* name, float* array, int size);
 
-bool twk_get(const char* category, const char* name, ds::Color* value) {
-	return false;
-}
+bool twk_get(const TwkKey& key, int* value);
 
-bool twk_get(const char* category, const char* name, float* array, int size) {
-	return false;
-}
-// -------------------------------------------------------
-// internal token struct
-// -------------------------------------------------------
-struct TWKToken {
+bool twk_get(const TwkKey& key, uint32_t* value);
 
-	enum TokenType { EMPTY, NUMBER, NAME, DELIMITER, OPEN_BRACES, CLOSE_BRACES, ASSIGN };
+bool twk_get(const TwkKey& key, float* value);
 
-	TWKToken() {}
-	TWKToken(TokenType type) : type(type) {}
-	TWKToken(TokenType type, float v) : type(type), value(v) {}
-	TWKToken(TokenType type, int i, int s) : type(type), index(i), size(s) {}
+bool twk_get(const TwkKey& key, ds::vec2* value);
 
-	TokenType type;
-	float value;
-	int index;
-	int size;
-};
+bool twk_get(const TwkKey& key, ds::vec3* value);
 
+bool twk_get(const TwkKey& key, ds::vec4* value);
 
+bool twk_get(const TwkKey& key, ds::Color* value);
 
-// -------------------------------------------------------
-// save
-// -------------------------------------------------------
-void twk_save() {
-	char name[128];
-	FILE* fp = fopen("test.txt", "w");
-	int currentCategory = -1;
-	if (fp) {
-		for (size_t i = 0; i < _twkCtx->items.size(); ++i) {
-			const InternalTweakable& item = _twkCtx->items[i];
-			if (item.categoryIndex != currentCategory) {
-				if (currentCategory != -1) {
-					fprintf(fp,"}\n");
-				}
-				int cidx = static_cast<int>(item.categoryIndex);
-				int cnIdx = _twkCtx->categories[cidx].nameIndex;
-				char* src = _twkCtx->charBuffer.data + _twkCtx->charBuffer.indices[cnIdx];
-				size_t l = _twkCtx->charBuffer.sizes[cnIdx];
-				strncpy(name, src, l);
-				name[l] = '\0';
-				fprintf(fp, "%s {\n", name);
-				currentCategory = static_cast<int>(item.categoryIndex);
-			}
-			int nidx = item.nameIndex;
-			char* src = _twkCtx->charBuffer.data + _twkCtx->charBuffer.indices[nidx];
-			size_t l = _twkCtx->charBuffer.sizes[nidx];
-			strncpy(name, src, l);
-			name[l] = '\0';
-			fprintf(fp, "\t%s : ", name);
-			switch (item.type) {
-				case TweakableType::ST_INT: fprintf(fp, "%d\n", *item.ptr.iPtr); break;
-				case TweakableType::ST_UINT: fprintf(fp, "%d\n", *item.ptr.uiPtr); break;
-				case TweakableType::ST_FLOAT: fprintf(fp, "%g\n", *item.ptr.fPtr); break;
-				case TweakableType::ST_VEC2 : fprintf(fp, "%g, %g\n", item.ptr.v2Ptr->x, item.ptr.v2Ptr->y); break;
-				case TweakableType::ST_VEC3: fprintf(fp, "%g, %g, %g\n", item.ptr.v3Ptr->x, item.ptr.v3Ptr->y, item.ptr.v3Ptr->z); break;
-				case TweakableType::ST_VEC4: fprintf(fp, "%g, %g, %g, %g\n", item.ptr.v4Ptr->x, item.ptr.v4Ptr->y, item.ptr.v4Ptr->z, item.ptr.v4Ptr->w); break;
-				case TweakableType::ST_COLOR: {
-					for (int j = 0; j < 4; ++j) {
-						if (j != 0) {
-							fprintf(fp, ", ");
-						}
-						int v = static_cast<int>(item.ptr.cPtr->data[j] * 255.0f);
-						fprintf(fp, "%d", v);
-					}
-					fprintf(fp, "\n");
-					break;
-				}
-				case TweakableType::ST_ARRAY: {
-					int la = item.arrayLength;
-					for (int j = 0; j < la; ++j) {
-						if (j != 0) {
-							fprintf(fp, ", ");
-						}
-						fprintf(fp, "%g", item.ptr.arPtr[j]); 
+bool twk_get(const TwkKey& key, float* array, int size);
+
+bool twk_get(TwkHandle<int> handle, int* value);
+
+bool twk_get(TwkHandle<uint32_t> handle, uint32_t* value);
+
+bool twk_get(TwkHandle<float> handle, float* value);
+
+bool twk_get(TwkHandle<ds::vec2> handle, ds::vec2* value);
+
+bool twk_get(TwkHandle<ds::vec3> handle, ds::vec3* value);
+
+bool twk_get(TwkHandle<ds::vec4> handle, ds::vec4* value);
+
+bool twk_get(TwkHandle<ds::Color> handle, ds::Color* value);
+
+bool twk_get(TwkHandle<float*> handle, float* array, int size);
+
+bool twk_get(TwkHandle<TwkCurve> handle, TwkCurve* curve);
+
+void twk_set(TwkHandle<int> handle, int value);
+
+void twk_set(TwkHandle<uint32_t> handle, uint32_t value);
+
+void twk_set(TwkHandle<float> handle, float value);
+
+void twk_set(TwkHandle<ds::vec2> handle, const ds::vec2& value);
+
+void twk_set(TwkHandle<ds::vec3> handle, const ds::vec3& value);
+
+void twk_set(TwkHandle<ds::vec4> handle, const ds::vec4& value);
+
+void twk_set(TwkHandle<ds::Color> handle, const ds::Color& value);
+
+void twk_set(TwkHandle<float*> handle, const float* array, int size);
+
+void twk_set(TwkHandle<TwkCurve> handle, const float* keys, int count);
+
+float twk_curve_eval(const TwkCurve& curve, float t);
+
+void twk_curve_eval(const TwkCurve& curve, const float* t, float* out, int count);
+
+int twk_num_categories();
+
+const char* twk_get_category_name(int index);
+
+int twk_get_tweakables(int categoryIndex, Tweakable* ret, int max);
+
+int twk_get_tweakables(const char* category, Tweakable* ret, int max);
+
+void twk_shutdown();
+
+bool twk_load();
+
+bool twk_load_many(const char* const* files, int count);
+
+void twk_start_background_reload();
+
+bool twk_apply_pending();
+
+struct TwkSnapshotRef {
+	int offset;
+	int count;
+};
+
+void twk_enable_snapshots();
+
+void twk_snapshot_publish();
+
+TwkSnapshotRef twk_snapshot_ref(const char* category, const char* name);
+
+uint32_t twk_snapshot_begin();
+
+void twk_snapshot_load(const TwkSnapshotRef& ref, void* dest);
+
+bool twk_snapshot_retry(uint32_t sequence);
+
+bool twk_snapshot_read(const TwkSnapshotRef& ref, void* dest);
+
+void twk_parse(const char* text);
+
+char* twk_bake_binary(const char* text, size_t* size);
+
+bool twk_load_binary(const void* data, size_t size);
+
+bool twk_load_binary(const char* fileName);
+
+bool twk_verify();
+
+int twk_get_changed_categories(int* ret, int max);
+
+int twk_get_changed_tweakables(Tweakable* ret, int max);
+
+void twk_on_change(const char* category, const char* name, twkChangeCallback callback, void* user = 0);
+
+void twk_on_change(const char* category, twkChangeCallback callback, void* user = 0);
+
+bool twk_save();
+
+bool twk_save(const char* fileName);
+
+// -------------------------------------------------------
+// contexts
+// Every function above works on the default context that
+// is created by twk_init. Separate contexts are created
+// with twk_create and passed as first argument. Different
+// contexts can be used on different threads at the same
+// time.
+// -------------------------------------------------------
+TWKContext* twk_create(twkErrorHandler = 0);
+
+TWKContext* twk_create(const char* fileName, twkErrorHandler = 0);
+
+TWKContext* twk_create(const TwkAllocator& allocator, twkErrorHandler = 0);
+
+TWKContext* twk_create(const char* fileName, const TwkAllocator& allocator, twkErrorHandler = 0);
+
+void twk_destroy(TWKContext* ctx);
+
+TwkHandle<int> twk_add(TWKContext* ctx, const char* category, const char* name, int* value);
+
+TwkHandle<uint32_t> twk_add(TWKContext* ctx, const char* category, const char* name, uint32_t* value);
+
+TwkHandle<float> twk_add(TWKContext* ctx, const char* category, const char* name, float* value);
+
+TwkHandle<ds::vec2> twk_add(TWKContext* ctx, const char* category, const char* name, ds::vec2* value);
+
+TwkHandle<ds::vec3> twk_add(TWKContext* ctx, const char* category, const char* name, ds::vec3* value);
+
+TwkHandle<ds::vec4> twk_add(TWKContext* ctx, const char* category, const char* name, ds::vec4* value);
+
+TwkHandle<ds::Color> twk_add(TWKContext* ctx, const char* category, const char* name, ds::Color* value);
+
+TwkHandle<float*> twk_add(TWKContext* ctx, const char* category, const char* name, float* array,int size);
+
+TwkHandle<TwkCurve> twk_add(TWKContext* ctx, const char* category, const char* name, TwkCurve* curve, TwkCurveMode mode, const float* keys = 0, int count = 0);
+
+TwkHandle<int> twk_add(TWKContext* ctx, const TwkKey& key, int* value);
+
+TwkHandle<uint32_t> twk_add(TWKContext* ctx, const TwkKey& key, uint32_t* value);
+
+TwkHandle<float> twk_add(TWKContext* ctx, const TwkKey& key, float* value);
+
+TwkHandle<ds::vec2> twk_add(TWKContext* ctx, const TwkKey& key, ds::vec2* value);
+
+TwkHandle<ds::vec3> twk_add(TWKContext* ctx, const TwkKey& key, ds::vec3* value);
+
+TwkHandle<ds::vec4> twk_add(TWKContext* ctx, const TwkKey& key, ds::vec4* value);
+
+TwkHandle<ds::Color> twk_add(TWKContext* ctx, const TwkKey& key, ds::Color* value);
+
+TwkHandle<float*> twk_add(TWKContext* ctx, const TwkKey& key, float* array, int size);
+
+TwkHandle<TwkCurve> twk_add(TWKContext* ctx, const TwkKey& key, TwkCurve* curve, TwkCurveMode mode, const float* keys = 0, int count = 0);
+
+void twk_add_struct(TWKContext* ctx, const char* category, void* instance, const TwkField* fields, int numFields);
+
+void twk_add_struct(TWKContext* ctx, const char* const* categories, int count, void* first, size_t stride, const TwkField* fields, int numFields);
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, int* value);
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, uint32_t* value);
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, float* value);
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, ds::vec2* value);
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, ds::vec3* value);
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, ds::vec4* value);
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, ds::Color* value);
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, float* array, int size);
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, int* value);
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, uint32_t* value);
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, float* value);
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, ds::vec2* value);
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, ds::vec3* value);
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, ds::vec4* value);
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, ds::Color* value);
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, float* array, int size);
+
+bool twk_get(TWKContext* ctx, TwkHandle<int> handle, int* value);
+
+bool twk_get(TWKContext* ctx, TwkHandle<uint32_t> handle, uint32_t* value);
+
+bool twk_get(TWKContext* ctx, TwkHandle<float> handle, float* value);
+
+bool twk_get(TWKContext* ctx, TwkHandle<ds::vec2> handle, ds::vec2* value);
+
+bool twk_get(TWKContext* ctx, TwkHandle<ds::vec3> handle, ds::vec3* value);
+
+bool twk_get(TWKContext* ctx, TwkHandle<ds::vec4> handle, ds::vec4* value);
+
+bool twk_get(TWKContext* ctx, TwkHandle<ds::Color> handle, ds::Color* value);
+
+bool twk_get(TWKContext* ctx, TwkHandle<float*> handle, float* array, int size);
+
+bool twk_get(TWKContext* ctx, TwkHandle<TwkCurve> handle, TwkCurve* curve);
+
+void twk_set(TWKContext* ctx, TwkHandle<int> handle, int value);
+
+void twk_set(TWKContext* ctx, TwkHandle<uint32_t> handle, uint32_t value);
+
+void twk_set(TWKContext* ctx, TwkHandle<float> handle, float value);
+
+void twk_set(TWKContext* ctx, TwkHandle<ds::vec2> handle, const ds::vec2& value);
+
+void twk_set(TWKContext* ctx, TwkHandle<ds::vec3> handle, const ds::vec3& value);
+
+void twk_set(TWKContext* ctx, TwkHandle<ds::vec4> handle, const ds::vec4& value);
+
+void twk_set(TWKContext* ctx, TwkHandle<ds::Color> handle, const ds::Color& value);
+
+void twk_set(TWKContext* ctx, TwkHandle<float*> handle, const float* array, int size);
+
+void twk_set(TWKContext* ctx, TwkHandle<TwkCurve> handle, const float* keys, int count);
+
+int twk_num_categories(TWKContext* ctx);
+
+const char* twk_get_category_name(TWKContext* ctx, int index);
+
+int twk_get_tweakables(TWKContext* ctx, int categoryIndex, Tweakable* ret, int max);
+
+int twk_get_tweakables(TWKContext* ctx, const char* category, Tweakable* ret, int max);
+
+bool twk_load(TWKContext* ctx);
+
+bool twk_load_many(TWKContext* ctx, const char* const* files, int count);
+
+void twk_start_background_reload(TWKContext* ctx);
+
+bool twk_apply_pending(TWKContext* ctx);
+
+void twk_enable_snapshots(TWKContext* ctx);
+
+void twk_snapshot_publish(TWKContext* ctx);
+
+TwkSnapshotRef twk_snapshot_ref(TWKContext* ctx, const char* category, const char* name);
+
+uint32_t twk_snapshot_begin(TWKContext* ctx);
+
+void twk_snapshot_load(TWKContext* ctx, const TwkSnapshotRef& ref, void* dest);
+
+bool twk_snapshot_retry(TWKContext* ctx, uint32_t sequence);
+
+bool twk_snapshot_read(TWKContext* ctx, const TwkSnapshotRef& ref, void* dest);
+
+void twk_parse(TWKContext* ctx, const char* text);
+
+bool twk_load_binary(TWKContext* ctx, const void* data, size_t size);
+
+bool twk_load_binary(TWKContext* ctx, const char* fileName);
+
+bool twk_verify(TWKContext* ctx);
+
+int twk_get_changed_categories(TWKContext* ctx, int* ret, int max);
+
+int twk_get_changed_tweakables(TWKContext* ctx, Tweakable* ret, int max);
+
+void twk_on_change(TWKContext* ctx, const char* category, const char* name, twkChangeCallback callback, void* user = 0);
+
+void twk_on_change(TWKContext* ctx, const char* category, twkChangeCallback callback, void* user = 0);
+
+bool twk_save(TWKContext* ctx);
+
+bool twk_save(TWKContext* ctx, const char* fileName);
+
+TwkStats twk_stats(TWKContext* ctx);
+
+void twk_enable_trace(TWKContext* ctx, int maxEvents = 4096);
+
+bool twk_write_trace(TWKContext* ctx, const char* fileName);
+
+//#define GAMESETTINGS_IMPLEMENTATION
+
+#ifdef GAMESETTINGS_IMPLEMENTATION
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <locale.h>
+#endif
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <errno.h>
+#endif
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include <new>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#ifdef _MSC_VER
+#define TWK_NOINLINE __declspec(noinline)
+#else
+#define TWK_NOINLINE __attribute__((noinline))
+#endif
+
+#if !defined(TWK_NO_SIMD) && (defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define TWK_SIMD_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// -------------------------------------------------------
+// allocation
+// Every block carries a small header with its size so the
+// counters can be kept and blocks that had to be taken from
+// the heap are released there again.
+// -------------------------------------------------------
+struct TWKAllocHeader {
+	size_t size;
+	size_t heap;
+};
+
+struct TWKAllocCounters {
+	std::atomic<size_t> allocations;
+	std::atomic<size_t> frees;
+	std::atomic<size_t> bytesInUse;
+	std::atomic<size_t> peakBytes;
+	std::atomic<size_t> heapFallbacks;
+};
+
+static void* twk__heap_alloc(size_t size, void*) {
+	return malloc(size);
+}
+
+static void twk__heap_free(void* ptr, void*) {
+	free(ptr);
+}
+
+static TwkAllocator _twkAllocator = { twk__heap_alloc, twk__heap_free, 0 };
+
+static TWKAllocCounters _twkAllocCounters;
+
+static void* twk__alloc(size_t size) {
+	size_t total = size + sizeof(TWKAllocHeader);
+	TWKAllocHeader* header = static_cast<TWKAllocHeader*>(_twkAllocator.alloc(total, _twkAllocator.user));
+	size_t heap = 0;
+	if (header == 0) {
+		header = static_cast<TWKAllocHeader*>(malloc(total));
+		heap = 1;
+		++_twkAllocCounters.heapFallbacks;
+	}
+	header->size = size;
+	header->heap = heap;
+	++_twkAllocCounters.allocations;
+	size_t inUse = _twkAllocCounters.bytesInUse.fetch_add(size) + size;
+	size_t peak = _twkAllocCounters.peakBytes.load();
+	while (inUse > peak && !_twkAllocCounters.peakBytes.compare_exchange_weak(peak, inUse)) {
+	}
+	return header + 1;
+}
+
+static void twk__free(void* ptr) {
+	if (ptr == 0) {
+		return;
+	}
+	TWKAllocHeader* header = static_cast<TWKAllocHeader*>(ptr) - 1;
+	++_twkAllocCounters.frees;
+	_twkAllocCounters.bytesInUse -= header->size;
+	if (header->heap != 0) {
+		free(header);
+	}
+	else {
+		_twkAllocator.free(header, _twkAllocator.user);
+	}
+}
+
+template<class T, class... Args>
+static T* twk__new(Args&&... args) {
+	return new (twk__alloc(sizeof(T))) T(std::forward<Args>(args)...);
+}
+
+template<class T>
+static void twk__delete(T* ptr) {
+	if (ptr != 0) {
+		ptr->~T();
+		twk__free(ptr);
+	}
+}
+
+template<class T>
+static T* twk__alloc_array(size_t count) {
+	return static_cast<T*>(twk__alloc(count * sizeof(T)));
+}
+
+// -------------------------------------------------------
+// std::vector allocator that uses the hooks
+// -------------------------------------------------------
+template<class T>
+struct TWKStlAllocator {
+	typedef T value_type;
+	TWKStlAllocator() {}
+	template<class U> TWKStlAllocator(const TWKStlAllocator<U>&) {}
+	T* allocate(size_t count) {
+		return twk__alloc_array<T>(count);
+	}
+	void deallocate(T* ptr, size_t) {
+		twk__free(ptr);
+	}
+};
+
+template<class T, class U>
+bool operator==(const TWKStlAllocator<T>&, const TWKStlAllocator<U>&) {
+	return true;
+}
+
+template<class T, class U>
+bool operator!=(const TWKStlAllocator<T>&, const TWKStlAllocator<U>&) {
+	return false;
+}
+
+template<class T>
+using TWKVector = std::vector<T, TWKStlAllocator<T> >;
+
+// -------------------------------------------------------
+// fixed arena
+// A bump allocator inside the memory passed by the user.
+// Only the most recent block can be given back, everything
+// else is reclaimed once all blocks are released.
+// -------------------------------------------------------
+struct TWKArena {
+	std::mutex lock;
+	char* base;
+	size_t capacity;
+	size_t used;
+	size_t last;
+	size_t live;
+};
+
+static void* twk__arena_alloc(size_t size, void* user) {
+	TWKArena* arena = static_cast<TWKArena*>(user);
+	std::lock_guard<std::mutex> guard(arena->lock);
+	size_t aligned = (size + 15) & ~static_cast<size_t>(15);
+	if (arena->capacity - arena->used < aligned) {
+		return 0;
+	}
+	arena->last = arena->used;
+	arena->used += aligned;
+	++arena->live;
+	return arena->base + arena->last;
+}
+
+static void* twk__arena_alloc_failed(size_t, void*) {
+	return 0;
+}
+
+static void twk__arena_free(void* ptr, void* user) {
+	TWKArena* arena = static_cast<TWKArena*>(user);
+	std::lock_guard<std::mutex> guard(arena->lock);
+	if (--arena->live == 0) {
+		arena->used = 0;
+	}
+	else if (static_cast<char*>(ptr) == arena->base + arena->last) {
+		arena->used = arena->last;
+	}
+}
+
+// -------------------------------------------------------
+// game settings item
+// -------------------------------------------------------
+
+// -------------------------------------------------------
+// contentHash is the hash of the text between the braces of
+// the category block at the last parse. The generations
+// refer to the parse in which the block was last seen and
+// last skipped because the hash did not change.
+// -------------------------------------------------------
+struct TWKCategory {
+	uint32_t hash;
+	int nameIndex;
+	bool hashValid;
+	uint64_t contentHash;
+	int seenGeneration;
+	int skippedGeneration;
+	int notifyStamp;
+	// struct block and instance if twk_add_struct created it
+	int structBlock;
+	int structInstance;
+};
+
+// -------------------------------------------------------
+// struct blocks
+// twk_add_struct stores the field table once per call. The
+// items of instance i start at firstItem + i * numFields in
+// field order. The fields of a category created by the call
+// are resolved through the table of its block so they take
+// no slot in the item index.
+// -------------------------------------------------------
+struct TWKStructField {
+	uint32_t hash;
+	int nameIndex;
+};
+
+struct TWKStructBlock {
+	int firstItem;
+	int firstField;
+	int numFields;
+};
+
+// -------------------------------------------------------
+// item store
+// The items are kept in parallel arrays. Lookups and the
+// found sweeps only walk the dense hot arrays while data
+// that is only needed for saving, reporting, snapshots and
+// callbacks lives in the cold array.
+// -------------------------------------------------------
+union TWKValuePtr {
+	int* iPtr;
+	uint32_t* uiPtr;
+	float* fPtr;
+	ds::vec2* v2Ptr;
+	ds::vec3* v3Ptr;
+	ds::vec4* v4Ptr;
+	ds::Color* cPtr;
+	float* arPtr;
+	TwkCurve* curvePtr;
+};
+
+// -------------------------------------------------------
+// arrayLength is the number of values of an array and the
+// number of values per key of a curve. changedStamp tells
+// if the item is already in the changed list.
+// -------------------------------------------------------
+struct TWKItemInfo {
+	int nameIndex;
+	int length;
+	int arrayLength;
+	int snapshotSlot;
+	int notifyStamp;
+	int changedStamp;
+};
+
+struct TWKItemStore {
+	// hot
+	TWKVector<uint32_t> hashes;
+	TWKVector<uint32_t> categories;
+	TWKVector<uint8_t> types;
+	TWKVector<TWKValuePtr> ptrs;
+	TWKVector<uint8_t> found;
+	TWKVector<int> setGenerations;
+	// cold
+	TWKVector<TWKItemInfo> info;
+};
+
+// -------------------------------------------------------
+// string arena
+// Strings are copied into pages that are never moved or
+// released before shutdown so every name pointer handed out
+// stays valid. Every new page is twice as large as the last.
+// -------------------------------------------------------
+#ifndef TWK_ARENA_PAGE_SIZE
+#define TWK_ARENA_PAGE_SIZE 4096
+#endif
+
+struct TWKStringArena {
+	TWKVector<char*> pages;
+	size_t pageSize;
+	size_t used;
+	TWKVector<const char*> strings;
+	TWKVector<uint32_t> lengths;
+};
+
+// -------------------------------------------------------
+// internal hash index (open addressing / linear probing)
+// maps a 64 bit key to an index (-1 = empty slot). Key and
+// value share a slot so a probe only touches one cache line.
+// Several slots can have the same key, the callers compare
+// the names to tell them apart. The name index in the string
+// arena fills the padding of the slot so the compare does
+// not have to go through the entry first.
+// -------------------------------------------------------
+struct TWKHashSlot {
+	uint64_t key;
+	int value;
+	int name;
+};
+
+struct TWKHashIndex {
+	TWKHashSlot* slots;
+	int capacity;
+	int count;
+};
+
+// -------------------------------------------------------
+// file watching
+// Windows and other platforms compare the modification time
+// on every twk_load. On Linux a thread blocks on inotify for
+// the directory of the settings file - this also catches
+// editors that save by writing a temp file and renaming it.
+// Bursts of events are coalesced into one change once the
+// directory has been quiet for TWK_WATCH_COALESCE_MS so
+// twk_load only has to check an atomic flag.
+// -------------------------------------------------------
+#ifndef TWK_WATCH_COALESCE_MS
+#define TWK_WATCH_COALESCE_MS 50
+#endif
+
+struct TWKFileWatch {
+#ifdef _WIN32
+	FILETIME filetime;
+#else
+	struct timespec filetime;
+#endif
+#ifdef __linux__
+	int inotifyFd;
+	int wakeFds[2];
+	char baseName[256];
+	std::atomic<bool> changed;
+	std::thread* thread;
+#endif
+};
+
+#ifdef _WIN32
+static bool twk__get_filetime(const char* fileName, FILETIME* time) {
+	// no file sharing mode
+	HANDLE hFile = CreateFile(fileName, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+	if (hFile != INVALID_HANDLE_VALUE) {
+		// Retrieve the file times for the file.
+		GetFileTime(hFile, NULL, NULL, time);
+		CloseHandle(hFile);
+		return true;
+	}
+	return false;
+}
+
+static bool twk__is_newer(const FILETIME* current, const FILETIME* now) {
+	return CompareFileTime(current, now) == -1;
+}
+#else
+static bool twk__get_filetime(const char* fileName, struct timespec* time) {
+	struct stat st;
+	if (stat(fileName, &st) == 0) {
+#ifdef __APPLE__
+		*time = st.st_mtimespec;
+#else
+		*time = st.st_mtim;
+#endif
+		return true;
+	}
+	return false;
+}
+
+static bool twk__is_newer(const struct timespec* current, const struct timespec* now) {
+	return current->tv_sec < now->tv_sec || (current->tv_sec == now->tv_sec && current->tv_nsec < now->tv_nsec);
+}
+#endif
+
+#ifdef __linux__
+static void twk__watch_thread(TWKFileWatch* watch) {
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct pollfd fds[2];
+	fds[0].fd = watch->inotifyFd;
+	fds[0].events = POLLIN;
+	fds[1].fd = watch->wakeFds[0];
+	fds[1].events = POLLIN;
+	bool pending = false;
+	for (;;) {
+		int r = poll(fds, 2, pending ? TWK_WATCH_COALESCE_MS : -1);
+		if (r < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		if (fds[1].revents != 0) {
+			break;
+		}
+		if (r == 0) {
+			// quiet period is over
+			pending = false;
+			watch->changed.store(true, std::memory_order_release);
+			continue;
+		}
+		ssize_t len = read(watch->inotifyFd, buffer, sizeof(buffer));
+		for (ssize_t i = 0; i < len; ) {
+			const struct inotify_event* e = reinterpret_cast<const struct inotify_event*>(buffer + i);
+			if (e->len > 0 && strcmp(e->name, watch->baseName) == 0) {
+				pending = true;
+			}
+			i += sizeof(struct inotify_event) + e->len;
+		}
+	}
+}
+#endif
+
+// -------------------------------------------------------
+// start watching the file
+// -------------------------------------------------------
+static void twk__watch_start(TWKFileWatch* watch, const char* fileName) {
+	memset(&watch->filetime, 0, sizeof(watch->filetime));
+#ifdef __linux__
+	watch->changed.store(false);
+	watch->thread = 0;
+	watch->inotifyFd = -1;
+	const char* slash = strrchr(fileName, '/');
+	char directory[1024];
+	if (slash == 0) {
+		strcpy(directory, ".");
+		slash = fileName - 1;
+	}
+	else {
+		size_t l = static_cast<size_t>(slash - fileName);
+		if (l >= sizeof(directory)) {
+			return;
+		}
+		memcpy(directory, fileName, l);
+		directory[l] = '\0';
+	}
+	if (strlen(slash + 1) >= sizeof(watch->baseName)) {
+		return;
+	}
+	strcpy(watch->baseName, slash + 1);
+	int fd = inotify_init1(IN_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	if (inotify_add_watch(fd, directory, IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE) < 0 || pipe(watch->wakeFds) != 0) {
+		close(fd);
+		return;
+	}
+	watch->inotifyFd = fd;
+	watch->thread = twk__new<std::thread>(twk__watch_thread, watch);
+#endif
+}
+
+// -------------------------------------------------------
+// has the file been changed since the last reset
+// -------------------------------------------------------
+static bool twk__watch_changed(TWKFileWatch* watch, const char* fileName) {
+#ifdef __linux__
+	if (watch->thread != 0) {
+		return watch->changed.load(std::memory_order_acquire);
+	}
+#endif
+#ifdef _WIN32
+	FILETIME now;
+#else
+	struct timespec now;
+#endif
+	if (twk__get_filetime(fileName, &now)) {
+		return twk__is_newer(&watch->filetime, &now);
+	}
+	return false;
+}
+
+// -------------------------------------------------------
+// called right before the file is read
+// -------------------------------------------------------
+static void twk__watch_reset(TWKFileWatch* watch, const char* fileName) {
+#ifdef __linux__
+	if (watch->thread != 0) {
+		watch->changed.store(false, std::memory_order_release);
+		return;
+	}
+#endif
+	twk__get_filetime(fileName, &watch->filetime);
+}
+
+// -------------------------------------------------------
+// stop watching
+// -------------------------------------------------------
+static void twk__watch_stop(TWKFileWatch* watch) {
+#ifdef __linux__
+	if (watch->thread != 0) {
+		char c = 0;
+		if (write(watch->wakeFds[1], &c, 1) == 1) {
+			watch->thread->join();
+		}
+		else {
+			watch->thread->detach();
+		}
+		twk__delete(watch->thread);
+		watch->thread = 0;
+		close(watch->wakeFds[0]);
+		close(watch->wakeFds[1]);
+		close(watch->inotifyFd);
+		watch->inotifyFd = -1;
+	}
+#endif
+}
+
+// -------------------------------------------------------
+// staged values
+// A parse into a stage only records what the file contains
+// and does not touch the registered items. Resolving maps
+// every entry to an item and converts the values into the
+// memory layout of the item so applying is a plain copy.
+// -------------------------------------------------------
+struct TWKStageEntry {
+	uint32_t categoryHash;
+	uint32_t nameHash;
+	// index of the category name in the categories of the stage
+	int category;
+	// offset of the name in the names of the stage
+	int name;
+	int offset;
+	int count;
+	int item;
+};
+
+// -------------------------------------------------------
+// derived values
+// "name : expression" is compiled into a small program in
+// reverse polish notation. The keys it references are kept
+// in a list per expression by their hashes and the program
+// reads them by their slot in that list. An entry of a
+// stage with a count of -1 is a derived value and its
+// offset is the index of the expression in the stage.
+// -------------------------------------------------------
+#ifndef TWK_EXPR_MAX_STACK
+#define TWK_EXPR_MAX_STACK 32
+#endif
+#ifndef TWK_EXPR_MAX_REFS
+#define TWK_EXPR_MAX_REFS 32
+#endif
+
+enum TWKExprCode { TWK_OP_CONST, TWK_OP_REF, TWK_OP_ADD, TWK_OP_SUB, TWK_OP_MUL, TWK_OP_DIV, TWK_OP_NEG, TWK_OP_STORE };
+
+struct TWKExprOp {
+	int code;
+	int ref;
+	float value;
+};
+
+struct TWKStageDerived {
+	uint64_t hash;
+	int name;
+	int firstOp;
+	int numOps;
+	int firstRef;
+	int numRefs;
+};
+
+// -------------------------------------------------------
+// includes
+// Included files are parsed in place of the directive. Every
+// nesting level reads into its own buffer which is kept for
+// the next reload.
+// -------------------------------------------------------
+#ifndef TWK_MAX_INCLUDE_DEPTH
+#define TWK_MAX_INCLUDE_DEPTH 8
+#endif
+
+struct TWKIncludes {
+	const char* fileName;
+	TWKVector<char>* buffers;
+	int depth;
+};
+
+// -------------------------------------------------------
+// reload statistics
+// A reload collects its counters either in the context or,
+// when it is parsed on another thread, in its stage which is
+// merged into the context when the stage is applied.
+// -------------------------------------------------------
+struct TWKReload {
+	TwkReloadStats stats;
+	double loadStart;
+	double parseStart;
+	uint32_t thread;
+};
+
+struct TWKTraceEvent {
+	const char* name;
+	const char* fileName;
+	double start;
+	double duration;
+	uint32_t thread;
+	size_t bytes;
+	uint32_t tokens;
+	uint32_t keys;
+};
+
+// -------------------------------------------------------
+// The names buffer holds the category and key names, the
+// paths of all included files and the paths that could not
+// be read.
+// -------------------------------------------------------
+struct TWKStage {
+	TWKVector<TWKStageEntry> entries;
+	TWKVector<float> values;
+	TWKVector<TWKStageDerived> derived;
+	TWKVector<TWKExprOp> ops;
+	TWKVector<uint64_t> refs;
+	TWKVector<int> categories;
+	TWKVector<int> includes;
+	TWKVector<int> failed;
+	TWKVector<char> names;
+	TWKVector<char> buffers[TWK_MAX_INCLUDE_DEPTH];
+	TWKReload reload;
+	// number of items when the entries were resolved
+	size_t resolvedItems;
+};
+
+// -------------------------------------------------------
+// watched source file - the files passed to twk_load_many
+// are roots and own a stage, included files are watched so
+// any change triggers a reload of the roots.
+// -------------------------------------------------------
+struct TWKSource {
+	const char* fileName;
+	TWKFileWatch watch;
+	bool root;
+	// the stage holds the resolved values of the current file
+	bool loaded;
+	TWKStage stage;
+	TWKVector<char> buffer;
+};
+
+// -------------------------------------------------------
+// snapshots (opt-in)
+// Reader threads must not read through the registered
+// pointers while a reload writes them. With snapshots enabled
+// every reload also copies the values of all items into a
+// store of atomic 4 byte slots guarded by a seqlock. The store
+// is made of fixed size chunks which are never moved or freed
+// before shutdown so readers never need to take the lock.
+// -------------------------------------------------------
+#ifndef TWK_SNAPSHOT_CHUNK_SIZE
+#define TWK_SNAPSHOT_CHUNK_SIZE 4096
+#endif
+#ifndef TWK_SNAPSHOT_MAX_CHUNKS
+#define TWK_SNAPSHOT_MAX_CHUNKS 1024
+#endif
+
+struct TWKSnapshotStore {
+	std::atomic<uint32_t> sequence;
+	std::atomic<std::atomic<uint32_t>*> chunks[TWK_SNAPSHOT_MAX_CHUNKS];
+	int size;
+	size_t items;
+	bool enabled;
+};
+
+// -------------------------------------------------------
+// change callbacks
+// A callback without name is registered for the whole
+// category. Notifications are collected while holding the
+// lock and dispatched after it has been released so the
+// callbacks are free to call the API.
+// -------------------------------------------------------
+struct TWKCallback {
+	uint32_t categoryHash;
+	uint32_t nameHash;
+	// the names live in the string arena
+	int categoryNameIndex;
+	int nameIndex;
+	bool category;
+	twkChangeCallback callback;
+	void* user;
+};
+
+struct TWKNotification {
+	twkChangeCallback callback;
+	void* user;
+	int categoryNameIndex;
+	int nameIndex;
+};
+
+// -------------------------------------------------------
+// value pool
+// Values of the file without a registered item are kept as
+// parsed so twk_get can still return them. Every key owns a
+// range of the values which is reused as long as the number
+// of values does not grow. The requested type is applied
+// when the value is read. The pool is keyed by the hashes
+// only.
+// -------------------------------------------------------
+struct TWKPoolEntry {
+	int category;
+	int offset;
+	int count;
+	int capacity;
+	int setGeneration;
+	uint8_t found;
+};
+
+struct TWKValuePool {
+	TWKHashIndex index;
+	TWKVector<TWKPoolEntry> entries;
+	TWKVector<float> values;
+};
+
+// -------------------------------------------------------
+// derived value store
+// Every derived key owns ranges of the programs, the
+// references, the inputs it was last evaluated with and
+// its result. The order lists the found derived values so
+// that every one comes after the derived values it reads.
+// -------------------------------------------------------
+struct TWKDerived {
+	uint64_t key;
+	uint64_t hash;
+	int category;
+	int nameIndex;
+	int firstOp;
+	int numOps;
+	int opCapacity;
+	int firstRef;
+	int numRefs;
+	int refCapacity;
+	int firstValue;
+	int numValues;
+	int valueCapacity;
+	int seenGeneration;
+	uint8_t found;
+	uint8_t sortedFound;
+	uint8_t valid;
+	uint8_t cyclic;
+	uint8_t mark;
+	uint8_t evaluated;
+};
+
+struct TWKDerivedStore {
+	TWKHashIndex index;
+	TWKVector<TWKDerived> entries;
+	TWKVector<TWKExprOp> ops;
+	TWKVector<uint64_t> refs;
+	TWKVector<float> inputs;
+	TWKVector<float> values;
+	TWKVector<int> order;
+	TWKVector<int> stack;
+	// twk_parse compiles into these before the expression is stored
+	TWKVector<TWKExprOp> compiledOps;
+	TWKVector<uint64_t> compiledRefs;
+	bool sorted;
+};
+
+// -------------------------------------------------------
+// internal settings context
+// -------------------------------------------------------
+struct TWKContext {
+	const char* fileName;
+	TWKFileWatch watch;
+	TWKItemStore items;
+	TWKVector<TWKCategory> categories;
+	TWKVector<TWKStructBlock> structBlocks;
+	TWKVector<TWKStructField> structFields;
+	bool loaded;
+	bool reloadable;
+	TWKStringArena strings;
+	TWKVector<char> fileBuffer;
+	TWKVector<char> binaryBuffer;
+	TWKVector<char> includeBuffers[TWK_MAX_INCLUDE_DEPTH];
+	// roots of twk_load_many and all included files
+	TWKVector<TWKSource*> sources;
+	int numRoots;
+	TWKHashIndex itemIndex;
+	// item after the one the text parser has set last
+	int nextItem;
+	TWKHashIndex categoryIndex;
+	TWKHashIndex stringIndex;
+	TWKValuePool pool;
+	TWKDerivedStore derived;
+	twkErrorHandler errorHandler;
+	// background reload - lock guards the items, categories and strings
+	std::mutex lock;
+	std::condition_variable reloadSignal;
+	std::thread* reloadThread;
+	bool stopReload;
+	bool loadFailed;
+	TWKStage stages[2];
+	int pendingStage;
+	TWKSnapshotStore snapshots;
+	// incremental reload
+	int generation;
+	TWKVector<int> changedItems;
+	int changedStamp;
+	// change callbacks
+	TWKVector<TWKCallback> callbacks;
+	TWKVector<TWKNotification> notifications;
+	TWKVector<TWKNotification> dispatching;
+	int notifyStamp;
+	// save
+	TWKVector<char> saveBuffer;
+	TWKVector<int> saveOrder;
+	TWKVector<int> saveOffsets;
+	// twk_load_many - the roots to parse and the stages to apply
+	TWKVector<int> rootQueue;
+	TWKVector<TWKStage*> rootStages;
+	// statistics and the ring buffer of trace events
+	TWKReload reload;
+	TwkStats stats;
+	TWKVector<TWKTraceEvent> trace;
+	size_t traceNext;
+	bool traceWrapped;
+};
+
+// -------------------------------------------------------
+// contexts
+// Every public function makes its context the current one
+// of the calling thread for the duration of the call, so
+// the internal functions work on _twkCtx and two contexts
+// can be used on two threads at the same time.
+// -------------------------------------------------------
+static thread_local TWKContext* _twkCtx = 0;
+
+static TWKContext* _twkDefault = 0;
+
+static std::mutex _twkContextLock;
+
+static int _twkContextCount = 0;
+
+struct TWKScope {
+	TWKContext* previous;
+	TWKScope(TWKContext* ctx) : previous(_twkCtx) {
+		_twkCtx = ctx;
+	}
+	~TWKScope() {
+		_twkCtx = previous;
+	}
+};
+
+// -------------------------------------------------------
+// internal hash index init / release
+// -------------------------------------------------------
+static void twk__index_init(TWKHashIndex* index) {
+	index->slots = 0;
+	index->capacity = 0;
+	index->count = 0;
+}
+
+static void twk__index_release(TWKHashIndex* index) {
+	twk__free(index->slots);
+	twk__index_init(index);
+}
+
+// -------------------------------------------------------
+// init
+// -------------------------------------------------------
+static void twk__common_init(twkErrorHandler errorHandler) {
+	_twkCtx->strings.pageSize = 0;
+	_twkCtx->strings.used = 0;
+	twk__index_init(&_twkCtx->itemIndex);
+	twk__index_init(&_twkCtx->categoryIndex);
+	twk__index_init(&_twkCtx->stringIndex);
+	twk__index_init(&_twkCtx->pool.index);
+	twk__index_init(&_twkCtx->derived.index);
+	_twkCtx->derived.sorted = true;
+	_twkCtx->errorHandler = errorHandler;
+	_twkCtx->reloadThread = 0;
+	_twkCtx->stopReload = false;
+	_twkCtx->loadFailed = false;
+	_twkCtx->pendingStage = -1;
+	_twkCtx->snapshots.sequence.store(0);
+	for (int i = 0; i < TWK_SNAPSHOT_MAX_CHUNKS; ++i) {
+		_twkCtx->snapshots.chunks[i].store(0);
+	}
+	_twkCtx->snapshots.size = 0;
+	_twkCtx->snapshots.items = 0;
+	_twkCtx->snapshots.enabled = false;
+	_twkCtx->generation = 0;
+	_twkCtx->changedStamp = 0;
+	_twkCtx->notifyStamp = 0;
+	_twkCtx->numRoots = 0;
+	_twkCtx->nextItem = 0;
+	memset(&_twkCtx->reload, 0, sizeof(TWKReload));
+	memset(&_twkCtx->stats, 0, sizeof(TwkStats));
+	_twkCtx->traceNext = 0;
+	_twkCtx->traceWrapped = false;
+}
+
+// -------------------------------------------------------
+// internal create context
+// The hooks can only be replaced while no context is alive
+// and are set before the context itself is allocated.
+// -------------------------------------------------------
+static TWKContext* twk__create_context(const char* fileName, const TwkAllocator* allocator, twkErrorHandler errorHandler) {
+	bool ignored = false;
+	{
+		std::lock_guard<std::mutex> guard(_twkContextLock);
+		if (allocator != 0) {
+			if (_twkContextCount == 0) {
+				_twkAllocator = *allocator;
+			}
+			else {
+				ignored = allocator->alloc != _twkAllocator.alloc || allocator->free != _twkAllocator.free || allocator->user != _twkAllocator.user;
+			}
+		}
+		++_twkContextCount;
+	}
+	TWKContext* ctx = twk__new<TWKContext>();
+	TWKScope scope(ctx);
+	_twkCtx->fileName = fileName;
+	_twkCtx->loaded = fileName == 0;
+	_twkCtx->reloadable = fileName != 0;
+	twk__common_init(errorHandler);
+	if (fileName != 0) {
+		twk__watch_start(&_twkCtx->watch, fileName);
+	}
+	if (ignored && errorHandler != 0) {
+		(*errorHandler)("Allocator ignored - other contexts are still alive");
+	}
+	return ctx;
+}
+
+TWKContext* twk_create(const char* fileName, twkErrorHandler errorHandler) {
+	return twk__create_context(fileName, 0, errorHandler);
+}
+
+TWKContext* twk_create(twkErrorHandler errorHandler) {
+	return twk__create_context(0, 0, errorHandler);
+}
+
+TWKContext* twk_create(const char* fileName, const TwkAllocator& allocator, twkErrorHandler errorHandler) {
+	return twk__create_context(fileName, &allocator, errorHandler);
+}
+
+TWKContext* twk_create(const TwkAllocator& allocator, twkErrorHandler errorHandler) {
+	return twk__create_context(0, &allocator, errorHandler);
+}
+
+void twk_init(const char* fileName, twkErrorHandler errorHandler) {
+	_twkDefault = twk_create(fileName, errorHandler);
+}
+
+void twk_init(twkErrorHandler errorHandler) {
+	_twkDefault = twk_create(errorHandler);
+}
+
+void twk_init(const char* fileName, const TwkAllocator& allocator, twkErrorHandler errorHandler) {
+	_twkDefault = twk_create(fileName, allocator, errorHandler);
+}
+
+void twk_init(const TwkAllocator& allocator, twkErrorHandler errorHandler) {
+	_twkDefault = twk_create(allocator, errorHandler);
+}
+
+// -------------------------------------------------------
+// fixed arena allocator
+// The arena bookkeeping is stored at the start of memory.
+// Returns an allocator that always fails if memory is too
+// small to hold it.
+// -------------------------------------------------------
+TwkAllocator twk_arena_allocator(void* memory, size_t capacity) {
+	TwkAllocator allocator = { twk__arena_alloc, twk__arena_free, 0 };
+	char* base = static_cast<char*>(memory);
+	size_t header = (sizeof(TWKArena) + 15) & ~static_cast<size_t>(15);
+	size_t padding = (16 - reinterpret_cast<uintptr_t>(base) % 16) % 16;
+	if (capacity < header + padding) {
+		allocator.user = 0;
+		allocator.alloc = twk__arena_alloc_failed;
+		return allocator;
+	}
+	TWKArena* arena = new (base + padding) TWKArena;
+	arena->base = base + padding + header;
+	arena->capacity = capacity - header - padding;
+	arena->used = 0;
+	arena->last = 0;
+	arena->live = 0;
+	allocator.user = arena;
+	return allocator;
+}
+
+// -------------------------------------------------------
+// allocation counters
+// -------------------------------------------------------
+void twk_get_allocation_stats(TwkAllocationStats* stats) {
+	stats->allocations = _twkAllocCounters.allocations.load();
+	stats->frees = _twkAllocCounters.frees.load();
+	stats->bytesInUse = _twkAllocCounters.bytesInUse.load();
+	stats->peakBytes = _twkAllocCounters.peakBytes.load();
+	stats->heapFallbacks = _twkAllocCounters.heapFallbacks.load();
+}
+
+
+// -------------------------------------------------------
+// destroy
+// The hooks fall back to the heap once the last context is
+// gone.
+// -------------------------------------------------------
+void twk_destroy(TWKContext* ctx) {
+	if (ctx != 0) {
+		TWKScope scope(ctx);
+		if (_twkCtx->reloadThread != 0) {
+			{
+				std::lock_guard<std::mutex> guard(_twkCtx->lock);
+				_twkCtx->stopReload = true;
+			}
+			_twkCtx->reloadSignal.notify_one();
+			_twkCtx->reloadThread->join();
+			twk__delete(_twkCtx->reloadThread);
+		}
+		if (_twkCtx->reloadable) {
+			twk__watch_stop(&_twkCtx->watch);
+		}
+		for (size_t i = 0; i < _twkCtx->sources.size(); ++i) {
+			twk__watch_stop(&_twkCtx->sources[i]->watch);
+			twk__delete(_twkCtx->sources[i]);
+		}
+		for (size_t i = 0; i < _twkCtx->strings.pages.size(); ++i) {
+			twk__free(_twkCtx->strings.pages[i]);
+		}
+		twk__index_release(&_twkCtx->itemIndex);
+		twk__index_release(&_twkCtx->categoryIndex);
+		twk__index_release(&_twkCtx->stringIndex);
+		twk__index_release(&_twkCtx->pool.index);
+		twk__index_release(&_twkCtx->derived.index);
+		for (int i = 0; i < TWK_SNAPSHOT_MAX_CHUNKS; ++i) {
+			twk__free(_twkCtx->snapshots.chunks[i].load());
+		}
+		twk__delete(_twkCtx);
+		std::lock_guard<std::mutex> guard(_twkContextLock);
+		if (--_twkContextCount == 0) {
+			_twkAllocator.alloc = twk__heap_alloc;
+			_twkAllocator.free = twk__heap_free;
+			_twkAllocator.user = 0;
+		}
+	}
+}
+
+// -------------------------------------------------------
+// shutdown
+// -------------------------------------------------------
+void twk_shutdown() {
+	twk_destroy(_twkDefault);
+	_twkDefault = 0;
+}
+
+// -------------------------------------------------------
+// Hashing
+// -------------------------------------------------------
+const uint32_t TWK__FNV_Prime = 0x01000193; 
+const uint32_t TWK__FNV_Seed = 0x811C9DC5;
+
+inline uint32_t twk_fnv1a(const char* text, uint32_t hash = TWK__FNV_Seed) {
+	const unsigned char* ptr = (const unsigned char*)text;
+	while (*ptr) {
+		hash = (*ptr++ ^ hash) * TWK__FNV_Prime;
+	}
+	return hash;
+}
+
+// -------------------------------------------------------
+// internal hash of a name inside the text - the same as
+// twk_fnv1a of the terminated name
+// -------------------------------------------------------
+static inline uint32_t twk__fnv1a(const char* text, size_t length) {
+	const unsigned char* ptr = reinterpret_cast<const unsigned char*>(text);
+	uint32_t hash = TWK__FNV_Seed;
+	for (size_t i = 0; i < length; ++i) {
+		hash = (ptr[i] ^ hash) * TWK__FNV_Prime;
+	}
+	return hash;
+}
+
+// -------------------------------------------------------
+// internal hash index
+// -------------------------------------------------------
+static inline uint64_t twk__make_key(uint32_t categoryHash, uint32_t nameHash) {
+	return (static_cast<uint64_t>(categoryHash) << 32) | nameHash;
+}
+
+static inline uint32_t twk__hash_slot(uint64_t key, int capacity) {
+	// mix the upper and lower part since both are already FNV hashes
+	uint64_t h = key * 0x9E3779B97F4A7C15ull;
+	return static_cast<uint32_t>(h >> 32) & (capacity - 1);
+}
+
+// -------------------------------------------------------
+// internal index find
+// probes is optional and counts the visited slots.
+// -------------------------------------------------------
+static int twk__index_find(const TWKHashIndex* index, uint64_t key, uint32_t* probes = 0) {
+	if (index->count == 0) {
+		return -1;
+	}
+	uint32_t slot = twk__hash_slot(key, index->capacity);
+	uint32_t visited = 1;
+	int ret = -1;
+	while (index->slots[slot].value != -1) {
+		if (index->slots[slot].key == key) {
+			ret = index->slots[slot].value;
+			break;
+		}
+		slot = (slot + 1) & (index->capacity - 1);
+		++visited;
+	}
+	if (probes != 0) {
+		*probes += visited;
+	}
+	return ret;
+}
+
+static void twk__index_insert_slot(TWKHashIndex* index, uint64_t key, int value, int name = -1) {
+	uint32_t slot = twk__hash_slot(key, index->capacity);
+	while (index->slots[slot].value != -1) {
+		slot = (slot + 1) & (index->capacity - 1);
+	}
+	index->slots[slot].key = key;
+	index->slots[slot].value = value;
+	index->slots[slot].name = name;
+	++index->count;
+}
+
+static void twk__index_rehash(TWKHashIndex* index, int capacity) {
+	int oldCapacity = index->capacity;
+	TWKHashSlot* oldSlots = index->slots;
+	index->capacity = capacity;
+	index->slots = twk__alloc_array<TWKHashSlot>(index->capacity);
+	index->count = 0;
+	for (int i = 0; i < index->capacity; ++i) {
+		index->slots[i].value = -1;
+	}
+	for (int i = 0; i < oldCapacity; ++i) {
+		if (oldSlots[i].value != -1) {
+			twk__index_insert_slot(index, oldSlots[i].key, oldSlots[i].value, oldSlots[i].name);
+		}
+	}
+	twk__free(oldSlots);
+}
+
+static void twk__index_grow(TWKHashIndex* index) {
+	twk__index_rehash(index, index->capacity == 0 ? 64 : index->capacity * 2);
+}
+
+// -------------------------------------------------------
+// makes room for count entries with a single rehash
+// -------------------------------------------------------
+static void twk__index_reserve(TWKHashIndex* index, int count) {
+	int capacity = index->capacity == 0 ? 64 : index->capacity;
+	while (count * 10 > capacity * 7) {
+		capacity *= 2;
+	}
+	if (capacity != index->capacity) {
+		twk__index_rehash(index, capacity);
+	}
+}
+
+// -------------------------------------------------------
+// adds the key if it is not already known - the first
+// registered entry wins just like the former linear scans
+// -------------------------------------------------------
+static void twk__index_add(TWKHashIndex* index, uint64_t key, int value) {
+	if (twk__index_find(index, key) != -1) {
+		return;
+	}
+	// keep the load factor below 0.7
+	if ((index->count + 1) * 10 > index->capacity * 7) {
+		twk__index_grow(index);
+	}
+	twk__index_insert_slot(index, key, value);
+}
+
+// -------------------------------------------------------
+// internal arena page allocation
+// Starts a new page that can hold at least size bytes. The
+// rest of the current page is given up.
+// -------------------------------------------------------
+static void twk__arena_new_page(TWKStringArena* arena, size_t size) {
+	size_t pageSize = arena->pageSize == 0 ? TWK_ARENA_PAGE_SIZE : arena->pageSize * 2;
+	while (pageSize < size) {
+		pageSize *= 2;
+	}
+	arena->pages.push_back(twk__alloc_array<char>(pageSize));
+	arena->pageSize = pageSize;
+	arena->used = 0;
+}
+
+// -------------------------------------------------------
+// makes room for chars bytes and count strings so that a
+// block of names is copied without further allocations
+// -------------------------------------------------------
+static void twk__arena_reserve(TWKStringArena* arena, size_t chars, size_t count) {
+	if (arena->pages.empty() || arena->used + chars > arena->pageSize) {
+		twk__arena_new_page(arena, chars);
+	}
+	arena->strings.reserve(arena->strings.size() + count);
+	arena->lengths.reserve(arena->lengths.size() + count);
+}
+
+// -------------------------------------------------------
+// compares the name of an index slot
+// -------------------------------------------------------
+static inline bool twk__slot_name_is(const TWKHashSlot& slot, const char* name, size_t length) {
+	const TWKStringArena& arena = _twkCtx->strings;
+	return arena.lengths[slot.name] == length && memcmp(arena.strings[slot.name], name, length) == 0;
+}
+
+// -------------------------------------------------------
+// internal find string
+// Walks all index entries with the same hash and compares
+// the actual strings so colliding names stay apart.
+// -------------------------------------------------------
+static int twk__find_string(const char* txt, size_t length, uint32_t hash) {
+	const TWKHashIndex* index = &_twkCtx->stringIndex;
+	if (index->count == 0) {
+		return -1;
+	}
+	uint32_t slot = twk__hash_slot(hash, index->capacity);
+	while (index->slots[slot].value != -1) {
+		if (index->slots[slot].key == hash && twk__slot_name_is(index->slots[slot], txt, length)) {
+			return index->slots[slot].value;
+		}
+		slot = (slot + 1) & (index->capacity - 1);
+	}
+	return -1;
+}
+
+// -------------------------------------------------------
+// internal add string to the arena
+// -------------------------------------------------------
+static int twk__add_string(const char* txt, size_t l, uint32_t hash) {
+	int strIdx = twk__find_string(txt, l, hash);
+	if (strIdx != -1) {
+		return strIdx;
+	}
+	TWKStringArena& arena = _twkCtx->strings;
+	if (arena.pages.empty() || arena.used + l + 1 > arena.pageSize) {
+		twk__arena_new_page(&arena, l + 1);
+	}
+	char* dest = arena.pages.back() + arena.used;
+	memcpy(dest, txt, l);
+	dest[l] = '\0';
+	arena.used += l + 1;
+	arena.strings.push_back(dest);
+	arena.lengths.push_back(static_cast<uint32_t>(l));
+	int idx = static_cast<int>(arena.strings.size()) - 1;
+	// keep the load factor below 0.7
+	TWKHashIndex* index = &_twkCtx->stringIndex;
+	if ((index->count + 1) * 10 > index->capacity * 7) {
+		twk__index_grow(index);
+	}
+	twk__index_insert_slot(index, hash, idx, idx);
+	return idx;
+}
+
+static int twk__add_string(const char* txt, uint32_t hash) {
+	return twk__add_string(txt, strlen(txt), hash);
+}
+
+static const char* twk__get_string(int index) {
+	return _twkCtx->strings.strings[index];
+}
+
+// -------------------------------------------------------
+// internal find category
+// Like the strings the categories only share a slot key
+// when their hashes collide so the names are compared.
+// -------------------------------------------------------
+static int twk__find_category(const char* category, size_t length, uint32_t hash) {
+	const TWKHashIndex* index = &_twkCtx->categoryIndex;
+	if (index->count == 0) {
+		return -1;
+	}
+	uint32_t slot = twk__hash_slot(hash, index->capacity);
+	while (index->slots[slot].value != -1) {
+		if (index->slots[slot].key == hash && twk__slot_name_is(index->slots[slot], category, length)) {
+			return index->slots[slot].value;
+		}
+		slot = (slot + 1) & (index->capacity - 1);
+	}
+	return -1;
+}
+
+static int twk__find_category(const char* category) {
+	size_t length = strlen(category);
+	return twk__find_category(category, length, twk__fnv1a(category, length));
+}
+// -------------------------------------------------------
+// internal add category
+// The caller has checked that the name is new so a category
+// with a colliding hash gets its own slot.
+// -------------------------------------------------------
+static int twk__add_category(const char* category, size_t length, uint32_t hash) {
+	TWKCategory cat;
+	cat.hash = hash;
+	cat.nameIndex = twk__add_string(category, length, hash);
+	cat.hashValid = false;
+	cat.contentHash = 0;
+	cat.seenGeneration = 0;
+	cat.skippedGeneration = 0;
+	cat.notifyStamp = 0;
+	cat.structBlock = -1;
+	cat.structInstance = 0;
+	_twkCtx->categories.push_back(cat);
+	int catIdx = static_cast<int>(_twkCtx->categories.size()) - 1;
+	// keep the load factor below 0.7
+	TWKHashIndex* index = &_twkCtx->categoryIndex;
+	if ((index->count + 1) * 10 > index->capacity * 7) {
+		twk__index_grow(index);
+	}
+	twk__index_insert_slot(index, cat.hash, catIdx, cat.nameIndex);
+	return catIdx;
+}
+
+static int twk__add_category(const char* category, uint32_t hash) {
+	return twk__add_category(category, strlen(category), hash);
+}
+
+// -------------------------------------------------------
+// internal add
+// -------------------------------------------------------
+static inline size_t twk__num_items() {
+	return _twkCtx->items.types.size();
+}
+
+static void twk__reserve_items(size_t count) {
+	TWKItemStore& items = _twkCtx->items;
+	items.hashes.reserve(count);
+	items.categories.reserve(count);
+	items.types.reserve(count);
+	items.ptrs.reserve(count);
+	items.found.reserve(count);
+	items.setGenerations.reserve(count);
+	items.info.reserve(count);
+}
+
+// -------------------------------------------------------
+// internal find item
+// Items only share a slot key when their hashes collide so
+// the category and the name are compared like the strings.
+// -------------------------------------------------------
+static inline bool twk__item_is(int idx, int categoryIndex, const char* name, size_t length) {
+	const TWKStringArena& arena = _twkCtx->strings;
+	int nameIndex = _twkCtx->items.info[idx].nameIndex;
+	return _twkCtx->items.categories[idx] == static_cast<uint32_t>(categoryIndex) && arena.lengths[nameIndex] == length && memcmp(arena.strings[nameIndex], name, length) == 0;
+}
+
+// -------------------------------------------------------
+// internal find struct field
+// Returns the item of the field if the category belongs to
+// a struct block. The lookups that only know the hash pass
+// no name.
+// -------------------------------------------------------
+static int twk__find_field(int categoryIndex, const char* name, size_t length, uint32_t nameHash) {
+	const TWKCategory& cat = _twkCtx->categories[categoryIndex];
+	if (cat.structBlock == -1) {
+		return -1;
+	}
+	const TWKStructBlock& block = _twkCtx->structBlocks[cat.structBlock];
+	const TWKStringArena& arena = _twkCtx->strings;
+	for (int f = 0; f < block.numFields; ++f) {
+		const TWKStructField& field = _twkCtx->structFields[block.firstField + f];
+		if (field.hash == nameHash && (name == 0 || (arena.lengths[field.nameIndex] == length && memcmp(arena.strings[field.nameIndex], name, length) == 0))) {
+			return block.firstItem + cat.structInstance * block.numFields + f;
+		}
+	}
+	return -1;
+}
+
+static int twk__find_item(int categoryIndex, const char* name, size_t length, uint32_t nameHash, uint32_t* probes = 0) {
+	if (categoryIndex == -1) {
+		return -1;
+	}
+	int field = twk__find_field(categoryIndex, name, length, nameHash);
+	if (field != -1) {
+		return field;
+	}
+	const TWKHashIndex* index = &_twkCtx->itemIndex;
+	if (index->count == 0) {
+		return -1;
+	}
+	uint64_t key = twk__make_key(_twkCtx->categories[categoryIndex].hash, nameHash);
+	uint32_t slot = twk__hash_slot(key, index->capacity);
+	uint32_t visited = 1;
+	int ret = -1;
+	while (index->slots[slot].value != -1) {
+		const TWKHashSlot& s = index->slots[slot];
+		if (s.key == key && twk__slot_name_is(s, name, length) && _twkCtx->items.categories[s.value] == static_cast<uint32_t>(categoryIndex)) {
+			ret = s.value;
+			break;
+		}
+		slot = (slot + 1) & (index->capacity - 1);
+		++visited;
+	}
+	if (probes != 0) {
+		*probes += visited;
+	}
+	return ret;
+}
+
+// -------------------------------------------------------
+// internal find item by key
+// For the derived references and baked binaries which only
+// know the hashes.
+// -------------------------------------------------------
+static int twk__find_item(uint64_t key) {
+	int idx = twk__index_find(&_twkCtx->itemIndex, key);
+	if (idx == -1) {
+		int categoryIndex = twk__index_find(&_twkCtx->categoryIndex, key >> 32);
+		if (categoryIndex != -1) {
+			idx = twk__find_field(categoryIndex, 0, 0, static_cast<uint32_t>(key));
+		}
+	}
+	return idx;
+}
+
+// -------------------------------------------------------
+// internal append item
+// Adds the item to the store without indexing it.
+// -------------------------------------------------------
+static int twk__append_item(int catIdx, uint32_t nameHash, int nameIndex, TweakableType type) {
+	TWKItemStore& items = _twkCtx->items;
+	TWKValuePtr ptr;
+	ptr.fPtr = 0;
+	TWKItemInfo info;
+	info.nameIndex = nameIndex;
+	info.length = 0;
+	info.arrayLength = 0;
+	info.snapshotSlot = -1;
+	info.notifyStamp = 0;
+	info.changedStamp = -1;
+	items.hashes.push_back(nameHash);
+	items.categories.push_back(static_cast<uint32_t>(catIdx));
+	items.types.push_back(static_cast<uint8_t>(type));
+	items.ptrs.push_back(ptr);
+	items.found.push_back(0);
+	items.setGenerations.push_back(0);
+	items.info.push_back(info);
+	// the next parse has to apply the block of this category
+	_twkCtx->categories[catIdx].hashValid = false;
+	return static_cast<int>(twk__num_items()) - 1;
+}
+
+static size_t twk__push_item(int catIdx, uint32_t nameHash, int nameIndex, TweakableType type) {
+	int idx = twk__append_item(catIdx, nameHash, nameIndex, type);
+	// the first registered item of a name wins
+	const TWKStringArena& arena = _twkCtx->strings;
+	if (twk__find_item(catIdx, arena.strings[nameIndex], arena.lengths[nameIndex], nameHash) == -1) {
+		// keep the load factor below 0.7
+		TWKHashIndex* index = &_twkCtx->itemIndex;
+		if ((index->count + 1) * 10 > index->capacity * 7) {
+			twk__index_grow(index);
+		}
+		twk__index_insert_slot(index, twk__make_key(_twkCtx->categories[catIdx].hash, nameHash), idx, nameIndex);
+	}
+	return idx;
+}
+
+static size_t twk_internal_add(const char* category, const char* name, uint32_t categoryHash, uint32_t nameHash, TweakableType type) {
+	size_t length = strlen(category);
+	int catIdx = twk__find_category(category, length, categoryHash);
+	if (catIdx == -1) {
+		catIdx = twk__add_category(category, length, categoryHash);
+	}
+	return twk__push_item(catIdx, nameHash, twk__add_string(name, nameHash), type);
+}
+
+static size_t twk_internal_add(const char* category, const char* name, TweakableType type) {
+	return twk_internal_add(category, name, twk_fnv1a(category), twk_fnv1a(name), type);
+}
+
+// -------------------------------------------------------
+// add int
+// -------------------------------------------------------
+TwkHandle<int> twk_add(TWKContext* ctx, const char* category, const char* name, int* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(category, name, TweakableType::ST_INT);
+	_twkCtx->items.ptrs[idx].iPtr = value;
+	TwkHandle<int> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add uint32_t
+// -------------------------------------------------------
+TwkHandle<uint32_t> twk_add(TWKContext* ctx, const char* category, const char* name, uint32_t* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(category, name, TweakableType::ST_UINT);
+	_twkCtx->items.ptrs[idx].uiPtr = value;
+	TwkHandle<uint32_t> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add float
+// -------------------------------------------------------
+TwkHandle<float> twk_add(TWKContext* ctx, const char* category, const char* name, float* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(category, name, TweakableType::ST_FLOAT);
+	_twkCtx->items.ptrs[idx].fPtr = value;
+	TwkHandle<float> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add vec2
+// -------------------------------------------------------
+TwkHandle<ds::vec2> twk_add(TWKContext* ctx, const char* category, const char* name, ds::vec2* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(category, name, TweakableType::ST_VEC2);
+	_twkCtx->items.ptrs[idx].v2Ptr = value;
+	TwkHandle<ds::vec2> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add vec3
+// -------------------------------------------------------
+TwkHandle<ds::vec3> twk_add(TWKContext* ctx, const char* category, const char* name, ds::vec3* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(category, name, TweakableType::ST_VEC3);
+	_twkCtx->items.ptrs[idx].v3Ptr = value;
+	TwkHandle<ds::vec3> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add vec4
+// -------------------------------------------------------
+TwkHandle<ds::vec4> twk_add(TWKContext* ctx, const char* category, const char* name, ds::vec4* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(category, name, TweakableType::ST_VEC4);
+	_twkCtx->items.ptrs[idx].v4Ptr = value;
+	TwkHandle<ds::vec4> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add color
+// -------------------------------------------------------
+TwkHandle<ds::Color> twk_add(TWKContext* ctx, const char* category, const char* name, ds::Color* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(category, name, TweakableType::ST_COLOR);
+	_twkCtx->items.ptrs[idx].cPtr = value;
+	TwkHandle<ds::Color> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add array
+// -------------------------------------------------------
+TwkHandle<float*> twk_add(TWKContext* ctx, const char* category, const char* name, float* array, int size) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(category, name, TweakableType::ST_ARRAY);
+	_twkCtx->items.ptrs[idx].arPtr = array;
+	_twkCtx->items.info[idx].arrayLength = size;
+	TwkHandle<float*> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+static bool twk__set_curve(TwkCurve* curve, const float* keys, int count);
+
+// -------------------------------------------------------
+// add curve
+// The curve starts with the passed keys or as a constant 0
+// if they are not valid.
+// -------------------------------------------------------
+static void twk__init_curve(size_t idx, TwkCurve* curve, TwkCurveMode mode, const float* keys, int count) {
+	_twkCtx->items.ptrs[idx].curvePtr = curve;
+	_twkCtx->items.info[idx].arrayLength = mode == TWK_CURVE_HERMITE ? 3 : 2;
+	curve->mode = mode;
+	if (keys == 0 || !twk__set_curve(curve, keys, count)) {
+		twk__set_curve(curve, keys, 0);
+	}
+}
+
+TwkHandle<TwkCurve> twk_add(TWKContext* ctx, const char* category, const char* name, TwkCurve* curve, TwkCurveMode mode, const float* keys, int count) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(category, name, TweakableType::ST_CURVE);
+	twk__init_curve(idx, curve, mode, keys, count);
+	TwkHandle<TwkCurve> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add int with compile time hashed key
+// -------------------------------------------------------
+TwkHandle<int> twk_add(TWKContext* ctx, const TwkKey& key, int* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_INT);
+	_twkCtx->items.ptrs[idx].iPtr = value;
+	TwkHandle<int> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add uint32_t with compile time hashed key
+// -------------------------------------------------------
+TwkHandle<uint32_t> twk_add(TWKContext* ctx, const TwkKey& key, uint32_t* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_UINT);
+	_twkCtx->items.ptrs[idx].uiPtr = value;
+	TwkHandle<uint32_t> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add float with compile time hashed key
+// -------------------------------------------------------
+TwkHandle<float> twk_add(TWKContext* ctx, const TwkKey& key, float* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_FLOAT);
+	_twkCtx->items.ptrs[idx].fPtr = value;
+	TwkHandle<float> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add vec2 with compile time hashed key
+// -------------------------------------------------------
+TwkHandle<ds::vec2> twk_add(TWKContext* ctx, const TwkKey& key, ds::vec2* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_VEC2);
+	_twkCtx->items.ptrs[idx].v2Ptr = value;
+	TwkHandle<ds::vec2> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add vec3 with compile time hashed key
+// -------------------------------------------------------
+TwkHandle<ds::vec3> twk_add(TWKContext* ctx, const TwkKey& key, ds::vec3* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_VEC3);
+	_twkCtx->items.ptrs[idx].v3Ptr = value;
+	TwkHandle<ds::vec3> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add vec4 with compile time hashed key
+// -------------------------------------------------------
+TwkHandle<ds::vec4> twk_add(TWKContext* ctx, const TwkKey& key, ds::vec4* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_VEC4);
+	_twkCtx->items.ptrs[idx].v4Ptr = value;
+	TwkHandle<ds::vec4> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add color with compile time hashed key
+// -------------------------------------------------------
+TwkHandle<ds::Color> twk_add(TWKContext* ctx, const TwkKey& key, ds::Color* value) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_COLOR);
+	_twkCtx->items.ptrs[idx].cPtr = value;
+	TwkHandle<ds::Color> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add array with compile time hashed key
+// -------------------------------------------------------
+TwkHandle<float*> twk_add(TWKContext* ctx, const TwkKey& key, float* array, int size) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_ARRAY);
+	_twkCtx->items.ptrs[idx].arPtr = array;
+	_twkCtx->items.info[idx].arrayLength = size;
+	TwkHandle<float*> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add curve with compile time hashed key
+// -------------------------------------------------------
+TwkHandle<TwkCurve> twk_add(TWKContext* ctx, const TwkKey& key, TwkCurve* curve, TwkCurveMode mode, const float* keys, int count) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t idx = twk_internal_add(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_CURVE);
+	twk__init_curve(idx, curve, mode, keys, count);
+	TwkHandle<TwkCurve> handle = { static_cast<int>(idx) };
+	return handle;
+}
+
+// -------------------------------------------------------
+// add struct
+// Registers every field of count instances that are stride
+// bytes apart. The field names are hashed and stored once in
+// the field table of a new struct block. Every field is still
+// an item so handles, snapshots, saving and callbacks work as
+// with twk_add, but the fields of the categories created by
+// this call are found through the block and take no slot in
+// the item index. Fields of categories that already exist
+// are indexed like twk_add.
+// -------------------------------------------------------
+void twk_add_struct(TWKContext* ctx, const char* const* categories, int count, void* first, size_t stride, const TwkField* fields, int numFields) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	twk__reserve_items(twk__num_items() + static_cast<size_t>(count) * numFields);
+	twk__index_reserve(&_twkCtx->categoryIndex, static_cast<int>(_twkCtx->categories.size()) + count);
+	twk__index_reserve(&_twkCtx->stringIndex, static_cast<int>(_twkCtx->strings.strings.size()) + count + numFields);
+	_twkCtx->categories.reserve(_twkCtx->categories.size() + count);
+	// room for all names so the arena needs at most one new page
+	size_t chars = 0;
+	for (int i = 0; i < count; ++i) {
+		chars += strlen(categories[i]) + 1;
+	}
+	for (int f = 0; f < numFields; ++f) {
+		chars += strlen(fields[f].name) + 1;
+	}
+	twk__arena_reserve(&_twkCtx->strings, chars, count + numFields);
+	TWKStructBlock block;
+	block.firstItem = static_cast<int>(twk__num_items());
+	block.firstField = static_cast<int>(_twkCtx->structFields.size());
+	block.numFields = numFields;
+	for (int f = 0; f < numFields; ++f) {
+		TWKStructField field;
+		field.hash = twk_fnv1a(fields[f].name);
+		field.nameIndex = twk__add_string(fields[f].name, field.hash);
+		_twkCtx->structFields.push_back(field);
+	}
+	int blockIndex = static_cast<int>(_twkCtx->structBlocks.size());
+	_twkCtx->structBlocks.push_back(block);
+	const TWKStructField* table = _twkCtx->structFields.data() + block.firstField;
+	char* base = static_cast<char*>(first);
+	for (int i = 0; i < count; ++i) {
+		size_t length = strlen(categories[i]);
+		uint32_t categoryHash = twk__fnv1a(categories[i], length);
+		int catIdx = twk__find_category(categories[i], length, categoryHash);
+		bool own = catIdx == -1;
+		if (own) {
+			catIdx = twk__add_category(categories[i], length, categoryHash);
+			_twkCtx->categories[catIdx].structBlock = blockIndex;
+			_twkCtx->categories[catIdx].structInstance = i;
+		}
+		char* instance = base + i * stride;
+		for (int f = 0; f < numFields; ++f) {
+			size_t idx = own ? twk__append_item(catIdx, table[f].hash, table[f].nameIndex, fields[f].type) : twk__push_item(catIdx, table[f].hash, table[f].nameIndex, fields[f].type);
+			_twkCtx->items.ptrs[idx].fPtr = reinterpret_cast<float*>(instance + fields[f].offset);
+			_twkCtx->items.info[idx].arrayLength = fields[f].arrayLength;
+		}
+	}
+}
+
+void twk_add_struct(TWKContext* ctx, const char* category, void* instance, const TwkField* fields, int numFields) {
+	TWKScope scope(ctx);
+	twk_add_struct(ctx, &category, 1, instance, 0, fields, numFields);
+}
+
+// ------------------------------------------------------------
+// internal error reporting using the twkErrorHandle callback
+// ------------------------------------------------------------
+static void twk__report_error(const char* format, ...) {
+	if (_twkCtx->errorHandler != 0) {
+		va_list args;
+		va_start(args, format);
+		char buffer[1024];
+		memset(buffer, 0, sizeof(buffer));
+#ifdef _WIN32
+		vsnprintf_s(buffer, sizeof(buffer), _TRUNCATE, format, args);
+#else
+		vsnprintf(buffer, sizeof(buffer), format, args);
+#endif
+		(*_twkCtx->errorHandler)(buffer);
+		va_end(args);
+	}
+}
+
+// -------------------------------------------------------
+// internal number of 4 byte values of an item
+// -------------------------------------------------------
+static int twk__value_count(int index) {
+	switch (_twkCtx->items.types[index]) {
+		case ST_VEC2: return 2;
+		case ST_VEC3: return 3;
+		case ST_VEC4: return 4;
+		case ST_COLOR: return 4;
+		case ST_ARRAY: return _twkCtx->items.info[index].arrayLength;
+		// the whole curve including the table
+		case ST_CURVE: return static_cast<int>(sizeof(TwkCurve) / sizeof(float));
+		default: return 1;
+	}
+}
+
+// -------------------------------------------------------
+// internal convert
+// Converts the parsed values into the memory layout of the
+// type. Returns the number of 4 byte values or 0 if the
+// number of values does not match the type.
+// -------------------------------------------------------
+static int twk__convert(TweakableType type, int arrayLength, const float* values, int count, float* out) {
+	switch (type) {
+		case ST_INT: {
+			if (count != 1) {
+				return 0;
+			}
+			int v = static_cast<int>(values[0]);
+			memcpy(out, &v, sizeof(int));
+			return 1;
+		}
+		case ST_UINT: {
+			if (count != 1) {
+				return 0;
+			}
+			uint32_t v = static_cast<uint32_t>(values[0]);
+			memcpy(out, &v, sizeof(uint32_t));
+			return 1;
+		}
+		case ST_FLOAT: count = count == 1 ? 1 : 0; break;
+		case ST_VEC2: count = count == 2 ? 2 : 0; break;
+		case ST_VEC3: count = count == 3 ? 3 : 0; break;
+		case ST_VEC4: count = count == 4 ? 4 : 0; break;
+		case ST_COLOR: {
+			if (count != 4) {
+				return 0;
+			}
+			for (int i = 0; i < 4; ++i) {
+				out[i] = values[i] / 255.0f;
+			}
+			return 4;
+		}
+		case ST_ARRAY: count = count == arrayLength ? count : 0; break;
+		case ST_CURVE: {
+			// arrayLength is the number of values per key and the keys must be sorted
+			if (count == 0 || count % arrayLength != 0 || count > TWK_CURVE_MAX_KEYS * arrayLength) {
+				return 0;
+			}
+			for (int i = arrayLength; i < count; i += arrayLength) {
+				if (!(values[i] >= values[i - arrayLength])) {
+					return 0;
+				}
+			}
+			break;
+		}
+		default: count = 0; break;
+	}
+	if (out != values && count > 0) {
+		memcpy(out, values, count * sizeof(float));
+	}
+	return count;
+}
+
+// -------------------------------------------------------
+// internal pool set
+// Must be called while holding the lock.
+// -------------------------------------------------------
+static void twk__pool_set(int categoryIndex, uint64_t key, const float* values, int count) {
+	TWKValuePool& pool = _twkCtx->pool;
+	int idx = twk__index_find(&pool.index, key);
+	if (idx == -1) {
+		TWKPoolEntry entry;
+		entry.category = categoryIndex;
+		entry.offset = 0;
+		entry.count = 0;
+		entry.capacity = 0;
+		entry.setGeneration = 0;
+		entry.found = 0;
+		idx = static_cast<int>(pool.entries.size());
+		pool.entries.push_back(entry);
+		twk__index_add(&pool.index, key, idx);
+	}
+	TWKPoolEntry& entry = pool.entries[idx];
+	if (count > entry.capacity) {
+		entry.offset = static_cast<int>(pool.values.size());
+		entry.capacity = count;
+		pool.values.resize(pool.values.size() + count);
+	}
+	if (count > 0) {
+		memcpy(pool.values.data() + entry.offset, values, count * sizeof(float));
+	}
+	entry.count = count;
+	entry.found = 1;
+	entry.setGeneration = _twkCtx->generation;
+}
+
+static const TWKPoolEntry* twk__pool_find(uint64_t key) {
+	int idx = twk__index_find(&_twkCtx->pool.index, key);
+	if (idx == -1 || _twkCtx->pool.entries[idx].found == 0) {
+		return 0;
+	}
+	return &_twkCtx->pool.entries[idx];
+}
+
+// -------------------------------------------------------
+// internal get value
+// Copies the value of the registered item if the type
+// matches. Keys without an item are converted from the
+// values of the pool.
+// -------------------------------------------------------
+static bool twk__get_value(const char* category, const char* name, uint32_t categoryHash, uint32_t nameHash, TweakableType type, void* value) {
+	uint64_t key = twk__make_key(categoryHash, nameHash);
+	int idx = twk__find_item(twk__find_category(category, strlen(category), categoryHash), name, strlen(name), nameHash);
+	if (idx == -1) {
+		const TWKPoolEntry* entry = twk__pool_find(key);
+		return entry != 0 && twk__convert(type, entry->count, _twkCtx->pool.values.data() + entry->offset, entry->count, static_cast<float*>(value)) > 0;
+	}
+	if (_twkCtx->items.types[idx] != type) {
+		return false;
+	}
+	memcpy(value, _twkCtx->items.ptrs[idx].fPtr, twk__value_count(idx) * sizeof(float));
+	return true;
+}
+
+static bool twk__get_array(const char* category, const char* name, uint32_t categoryHash, uint32_t nameHash, float* array, int size) {
+	uint64_t key = twk__make_key(categoryHash, nameHash);
+	int idx = twk__find_item(twk__find_category(category, strlen(category), categoryHash), name, strlen(name), nameHash);
+	if (idx == -1) {
+		const TWKPoolEntry* entry = twk__pool_find(key);
+		if (entry == 0) {
+			return false;
+		}
+		memcpy(array, _twkCtx->pool.values.data() + entry->offset, (size < entry->count ? size : entry->count) * sizeof(float));
+		return true;
+	}
+	if (_twkCtx->items.types[idx] != ST_ARRAY) {
+		return false;
+	}
+	int length = _twkCtx->items.info[idx].arrayLength;
+	memcpy(array, _twkCtx->items.ptrs[idx].arPtr, (size < length ? size : length) * sizeof(float));
+	return true;
+}
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, int* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(category, name, twk_fnv1a(category), twk_fnv1a(name), TweakableType::ST_INT, value);
+}
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, uint32_t* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(category, name, twk_fnv1a(category), twk_fnv1a(name), TweakableType::ST_UINT, value);
+}
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, float* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(category, name, twk_fnv1a(category), twk_fnv1a(name), TweakableType::ST_FLOAT, value);
+}
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, ds::vec2* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(category, name, twk_fnv1a(category), twk_fnv1a(name), TweakableType::ST_VEC2, value);
+}
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, ds::vec3* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(category, name, twk_fnv1a(category), twk_fnv1a(name), TweakableType::ST_VEC3, value);
+}
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, ds::vec4* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(category, name, twk_fnv1a(category), twk_fnv1a(name), TweakableType::ST_VEC4, value);
+}
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, ds::Color* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(category, name, twk_fnv1a(category), twk_fnv1a(name), TweakableType::ST_COLOR, value);
+}
+
+bool twk_get(TWKContext* ctx, const char* category, const char* name, float* array, int size) {
+	TWKScope scope(ctx);
+	return twk__get_array(category, name, twk_fnv1a(category), twk_fnv1a(name), array, size);
+}
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, int* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_INT, value);
+}
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, uint32_t* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_UINT, value);
+}
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, float* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_FLOAT, value);
+}
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, ds::vec2* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_VEC2, value);
+}
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, ds::vec3* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_VEC3, value);
+}
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, ds::vec4* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_VEC4, value);
+}
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, ds::Color* value) {
+	TWKScope scope(ctx);
+	return twk__get_value(key.category, key.name, key.categoryHash, key.nameHash, TweakableType::ST_COLOR, value);
+}
+
+bool twk_get(TWKContext* ctx, const TwkKey& key, float* array, int size) {
+	TWKScope scope(ctx);
+	return twk__get_array(key.category, key.name, key.categoryHash, key.nameHash, array, size);
+}
+
+// -------------------------------------------------------
+// internal token struct
+// -------------------------------------------------------
+struct TWKToken {
+
+	enum TokenType { EMPTY, NUMBER, NAME, DELIMITER, OPEN_BRACES, CLOSE_BRACES, ASSIGN, INCLUDE, OPERATOR };
+
+	TWKToken() {}
+	TWKToken(TokenType type) : type(type) {}
+	TWKToken(TokenType type, float v) : type(type), value(v) {}
+	TWKToken(TokenType type, int i, int s) : type(type), index(i), size(s) {}
+
+	TokenType type;
+	float value;
+	int index;
+	int size;
+};
+
+
+
+// -------------------------------------------------------
+// internal shortest float formatting
+// Finds the shortest decimal that parses back to exactly the
+// same float, following Ryu (Ulf Adams, PLDI 2018). The
+// bounds of the rounding interval are scaled by a power of
+// ten using 64 bit multipliers so no big integer arithmetic
+// is needed and digits are removed until the bounds meet.
+// -------------------------------------------------------
+#define TWK__POW5_INV_BITCOUNT 59
+#define TWK__POW5_BITCOUNT 61
+
+static const uint64_t TWK__POW5_INV_SPLIT[31] = {
+	0x0800000000000001ull, 0x0666666666666667ull, 0x051EB851EB851EB9ull, 0x04189374BC6A7EFAull,
+	0x068DB8BAC710CB2Aull, 0x053E2D6238DA3C22ull, 0x0431BDE82D7B634Eull, 0x06B5FCA6AF2BD216ull,
+	0x055E63B88C230E78ull, 0x044B82FA09B5A52Dull, 0x06DF37F675EF6EAEull, 0x057F5FF85E592558ull,
+	0x0465E6604B7A8447ull, 0x0709709A125DA071ull, 0x05A126E1A84AE6C1ull, 0x0480EBE7B9D58567ull,
+	0x0734ACA5F6226F0Bull, 0x05C3BD5191B525A3ull, 0x049C97747490EAE9ull, 0x0760F253EDB4AB0Eull,
+	0x05E72843249088D8ull, 0x04B8ED0283A6D3E0ull, 0x078E480405D7B966ull, 0x060B6CD004AC9452ull,
+	0x04D5F0A66A23A9DBull, 0x07BCB43D769F762Bull, 0x063090312BB2C4EFull, 0x04F3A68DBC8F03F3ull,
+	0x07EC3DAF94180651ull, 0x065697BFA9ACD1DAull, 0x051212FFBAF0A7E2ull
+};
+
+static const uint64_t TWK__POW5_SPLIT[47] = {
+	0x1000000000000000ull, 0x1400000000000000ull, 0x1900000000000000ull, 0x1F40000000000000ull,
+	0x1388000000000000ull, 0x186A000000000000ull, 0x1E84800000000000ull, 0x1312D00000000000ull,
+	0x17D7840000000000ull, 0x1DCD650000000000ull, 0x12A05F2000000000ull, 0x174876E800000000ull,
+	0x1D1A94A200000000ull, 0x12309CE540000000ull, 0x16BCC41E90000000ull, 0x1C6BF52634000000ull,
+	0x11C37937E0800000ull, 0x16345785D8A00000ull, 0x1BC16D674EC80000ull, 0x1158E460913D0000ull,
+	0x15AF1D78B58C4000ull, 0x1B1AE4D6E2EF5000ull, 0x10F0CF064DD59200ull, 0x152D02C7E14AF680ull,
+	0x1A784379D99DB420ull, 0x108B2A2C28029094ull, 0x14ADF4B7320334B9ull, 0x19D971E4FE8401E7ull,
+	0x1027E72F1F128130ull, 0x1431E0FAE6D7217Cull, 0x193E5939A08CE9DBull, 0x1F8DEF8808B02452ull,
+	0x13B8B5B5056E16B3ull, 0x18A6E32246C99C60ull, 0x1ED09BEAD87C0378ull, 0x13426172C74D822Bull,
+	0x1812F9CF7920E2B6ull, 0x1E17B84357691B64ull, 0x12CED32A16A1B11Eull, 0x178287F49C4A1D66ull,
+	0x1D6329F1C35CA4BFull, 0x125DFA371A19E6F7ull, 0x16F578C4E0A060B5ull, 0x1CB2D6F618C878E3ull,
+	0x11EFC659CF7D4B8Dull, 0x166BB7F0435C9E71ull, 0x1C06A5EC5433C60Dull
+};
+
+// ceil(log2(5^e)) for e > 0, 1 for e = 0
+static inline int twk__pow5_bits(int e) {
+	return static_cast<int>((static_cast<uint32_t>(e) * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e))
+static inline int twk__log10_pow2(int e) {
+	return static_cast<int>((static_cast<uint32_t>(e) * 78913) >> 18);
+}
+
+// floor(log10(5^e))
+static inline int twk__log10_pow5(int e) {
+	return static_cast<int>((static_cast<uint32_t>(e) * 732923) >> 20);
+}
+
+static inline bool twk__multiple_of_pow5(uint32_t value, int p) {
+	int count = 0;
+	while (value != 0 && value % 5 == 0) {
+		value /= 5;
+		++count;
+	}
+	return count >= p;
+}
+
+static inline bool twk__multiple_of_pow2(uint32_t value, int p) {
+	return (value & ((1u << p) - 1)) == 0;
+}
+
+static inline uint32_t twk__mul_shift(uint32_t m, uint64_t factor, int shift) {
+	uint64_t low = static_cast<uint64_t>(m) * static_cast<uint32_t>(factor);
+	uint64_t high = static_cast<uint64_t>(m) * static_cast<uint32_t>(factor >> 32);
+	return static_cast<uint32_t>(((low >> 32) + high) >> (shift - 32));
+}
+
+// -------------------------------------------------------
+// internal shortest decimal of a finite positive float
+// value = digits * 10^exponent
+// -------------------------------------------------------
+static uint32_t twk__shortest_decimal(uint32_t bits, int* exponent) {
+	uint32_t ieeeMantissa = bits & ((1u << 23) - 1);
+	int ieeeExponent = static_cast<int>((bits >> 23) & 0xFF);
+	int e2;
+	uint32_t m2;
+	if (ieeeExponent == 0) {
+		e2 = 1 - 127 - 23 - 2;
+		m2 = ieeeMantissa;
+	}
+	else {
+		e2 = ieeeExponent - 127 - 23 - 2;
+		m2 = (1u << 23) | ieeeMantissa;
+	}
+	bool acceptBounds = (m2 & 1) == 0;
+	// the interval of all reals that round to this float
+	uint32_t mv = 4 * m2;
+	uint32_t mp = 4 * m2 + 2;
+	uint32_t mmShift = ieeeMantissa != 0 || ieeeExponent <= 1 ? 1 : 0;
+	uint32_t mm = 4 * m2 - 1 - mmShift;
+	uint32_t vr, vp, vm;
+	int e10;
+	bool vmIsTrailingZeros = false;
+	bool vrIsTrailingZeros = false;
+	uint32_t lastRemovedDigit = 0;
+	if (e2 >= 0) {
+		int q = twk__log10_pow2(e2);
+		e10 = q;
+		int k = TWK__POW5_INV_BITCOUNT + twk__pow5_bits(q) - 1;
+		int i = -e2 + q + k;
+		vr = twk__mul_shift(mv, TWK__POW5_INV_SPLIT[q], i);
+		vp = twk__mul_shift(mp, TWK__POW5_INV_SPLIT[q], i);
+		vm = twk__mul_shift(mm, TWK__POW5_INV_SPLIT[q], i);
+		if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+			int l = TWK__POW5_INV_BITCOUNT + twk__pow5_bits(q - 1) - 1;
+			lastRemovedDigit = twk__mul_shift(mv, TWK__POW5_INV_SPLIT[q - 1], -e2 + q - 1 + l) % 10;
+		}
+		if (q <= 9) {
+			if (mv % 5 == 0) {
+				vrIsTrailingZeros = twk__multiple_of_pow5(mv, q);
+			}
+			else if (acceptBounds) {
+				vmIsTrailingZeros = twk__multiple_of_pow5(mm, q);
+			}
+			else {
+				vp -= twk__multiple_of_pow5(mp, q) ? 1 : 0;
+			}
+		}
+	}
+	else {
+		int q = twk__log10_pow5(-e2);
+		e10 = q + e2;
+		int i = -e2 - q;
+		int k = twk__pow5_bits(i) - TWK__POW5_BITCOUNT;
+		int j = q - k;
+		vr = twk__mul_shift(mv, TWK__POW5_SPLIT[i], j);
+		vp = twk__mul_shift(mp, TWK__POW5_SPLIT[i], j);
+		vm = twk__mul_shift(mm, TWK__POW5_SPLIT[i], j);
+		if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+			j = q - 1 - (twk__pow5_bits(i + 1) - TWK__POW5_BITCOUNT);
+			lastRemovedDigit = twk__mul_shift(mv, TWK__POW5_SPLIT[i + 1], j) % 10;
+		}
+		if (q <= 1) {
+			vrIsTrailingZeros = true;
+			if (acceptBounds) {
+				vmIsTrailingZeros = mmShift == 1;
+			}
+			else {
+				--vp;
+			}
+		}
+		else if (q < 31) {
+			vrIsTrailingZeros = twk__multiple_of_pow2(mv, q - 1);
+		}
+	}
+	// remove digits as long as the bounds still differ
+	int removed = 0;
+	uint32_t output;
+	if (vmIsTrailingZeros || vrIsTrailingZeros) {
+		while (vp / 10 > vm / 10) {
+			vmIsTrailingZeros &= vm % 10 == 0;
+			vrIsTrailingZeros &= lastRemovedDigit == 0;
+			lastRemovedDigit = vr % 10;
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			++removed;
+		}
+		if (vmIsTrailingZeros) {
+			while (vm % 10 == 0) {
+				vrIsTrailingZeros &= lastRemovedDigit == 0;
+				lastRemovedDigit = vr % 10;
+				vr /= 10;
+				vp /= 10;
+				vm /= 10;
+				++removed;
+			}
+		}
+		if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0) {
+			// round even
+			lastRemovedDigit = 4;
+		}
+		output = vr + (((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5) ? 1 : 0);
+	}
+	else {
+		while (vp / 10 > vm / 10) {
+			lastRemovedDigit = vr % 10;
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			++removed;
+		}
+		output = vr + ((vr == vm || lastRemovedDigit >= 5) ? 1 : 0);
+	}
+	*exponent = e10 + removed;
+	return output;
+}
+
+static inline char* twk__write_digits(char* p, uint32_t value) {
+	char digits[10];
+	int n = 0;
+	do {
+		digits[n++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+	while (n > 0) {
+		*p++ = digits[--n];
+	}
+	return p;
+}
+
+// -------------------------------------------------------
+// internal write float
+// Writes at most 16 characters. Values around one are
+// written as plain decimals, everything else with an
+// exponent. The parser does not know inf and nan so infinity
+// is written as a number that overflows and nan as zero.
+// -------------------------------------------------------
+static char* twk__write_float(char* p, float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t magnitude = bits & 0x7FFFFFFF;
+	if (magnitude > 0x7F800000) {
+		*p++ = '0';
+		return p;
+	}
+	if ((bits >> 31) != 0) {
+		*p++ = '-';
+	}
+	if (magnitude == 0) {
+		*p++ = '0';
+		return p;
+	}
+	if (magnitude == 0x7F800000) {
+		memcpy(p, "1e39", 4);
+		return p + 4;
+	}
+	int exponent;
+	uint32_t digits = twk__shortest_decimal(magnitude, &exponent);
+	char text[10];
+	char* end = twk__write_digits(text, digits);
+	int length = static_cast<int>(end - text);
+	// position of the decimal point relative to the first digit
+	int point = length + exponent;
+	if (exponent >= 0 && point <= 9) {
+		memcpy(p, text, length);
+		p += length;
+		for (int i = 0; i < exponent; ++i) {
+			*p++ = '0';
+		}
+	}
+	else if (exponent < 0 && point > 0) {
+		memcpy(p, text, point);
+		p += point;
+		*p++ = '.';
+		memcpy(p, text + point, length - point);
+		p += length - point;
+	}
+	else if (point <= 0 && point > -4) {
+		*p++ = '0';
+		*p++ = '.';
+		for (int i = point; i < 0; ++i) {
+			*p++ = '0';
+		}
+		memcpy(p, text, length);
+		p += length;
+	}
+	else {
+		*p++ = text[0];
+		if (length > 1) {
+			*p++ = '.';
+			memcpy(p, text + 1, length - 1);
+			p += length - 1;
+		}
+		*p++ = 'e';
+		int e = point - 1;
+		if (e < 0) {
+			*p++ = '-';
+			e = -e;
+		}
+		p = twk__write_digits(p, static_cast<uint32_t>(e));
+	}
+	return p;
+}
+
+static char* twk__write_int(char* p, int value) {
+	uint32_t magnitude = static_cast<uint32_t>(value);
+	if (value < 0) {
+		*p++ = '-';
+		magnitude = 0u - magnitude;
+	}
+	return twk__write_digits(p, magnitude);
+}
+
+// -------------------------------------------------------
+// internal write color channel
+// The parser divides by 255 so the channel is written as the
+// value that gives exactly the same float again. This is the
+// plain integer for every color that was loaded from a file.
+// About one in 256 floats is not the result of any division
+// by 255 and is written as the closest one that is.
+// -------------------------------------------------------
+static char* twk__write_color(char* p, float channel) {
+	float v = floorf(channel * 255.0f + 0.5f);
+	if (v / 255.0f != channel) {
+		v = channel * 255.0f;
+		float error = fabsf(v / 255.0f - channel);
+		const float neighbours[2] = { nextafterf(v, -FLT_MAX), nextafterf(v, FLT_MAX) };
+		for (int i = 0; i < 2; ++i) {
+			float e = fabsf(neighbours[i] / 255.0f - channel);
+			if (e < error) {
+				v = neighbours[i];
+				error = e;
+			}
+		}
+	}
+	return twk__write_float(p, v);
+}
+
+// -------------------------------------------------------
+// internal format all items
+// The items are grouped by category with a counting sort so
+// every category is written as a single block. Returns the
+// number of characters in the buffer. Must be called while
+// holding the lock.
+// -------------------------------------------------------
+static size_t twk__format_settings(TWKVector<char>* buffer) {
+	const TWKItemStore& items = _twkCtx->items;
+	size_t num = twk__num_items();
+	TWKVector<int>& offsets = _twkCtx->saveOffsets;
+	TWKVector<int>& order = _twkCtx->saveOrder;
+	offsets.assign(_twkCtx->categories.size() + 1, 0);
+	for (size_t i = 0; i < num; ++i) {
+		++offsets[items.categories[i] + 1];
+	}
+	for (size_t i = 1; i < offsets.size(); ++i) {
+		offsets[i] += offsets[i - 1];
+	}
+	order.resize(num);
+	for (size_t i = 0; i < num; ++i) {
+		order[offsets[items.categories[i]]++] = static_cast<int>(i);
+	}
+	size_t used = 0;
+	int currentCategory = -1;
+	for (size_t o = 0; o < num; ++o) {
+		int i = order[o];
+		int categoryIndex = static_cast<int>(items.categories[i]);
+		const char* name = twk__get_string(items.info[i].nameIndex);
+		const char* categoryName = twk__get_string(_twkCtx->categories[categoryIndex].nameIndex);
+		size_t nameLength = _twkCtx->strings.lengths[items.info[i].nameIndex];
+		size_t categoryLength = _twkCtx->strings.lengths[_twkCtx->categories[categoryIndex].nameIndex];
+		// worst case of this item including the category header
+		size_t required = used + categoryLength + nameLength + 16 + twk__value_count(i) * 18;
+		if (required > buffer->size()) {
+			buffer->resize(required * 2);
+		}
+		char* p = buffer->data() + used;
+		if (categoryIndex != currentCategory) {
+			if (currentCategory != -1) {
+				*p++ = '}';
+				*p++ = '\n';
+			}
+			memcpy(p, categoryName, categoryLength);
+			p += categoryLength;
+			memcpy(p, " {\n", 3);
+			p += 3;
+			currentCategory = categoryIndex;
+		}
+		*p++ = '\t';
+		memcpy(p, name, nameLength);
+		p += nameLength;
+		memcpy(p, " : ", 3);
+		p += 3;
+		const TWKValuePtr& ptr = items.ptrs[i];
+		switch (items.types[i]) {
+			case TweakableType::ST_INT: p = twk__write_int(p, *ptr.iPtr); break;
+			case TweakableType::ST_UINT: p = twk__write_digits(p, *ptr.uiPtr); break;
+			case TweakableType::ST_COLOR: {
+				for (int j = 0; j < 4; ++j) {
+					if (j != 0) {
+						*p++ = ',';
+						*p++ = ' ';
+					}
+					p = twk__write_color(p, ptr.cPtr->data[j]);
+				}
+				break;
+			}
+			case TweakableType::ST_CURVE: {
+				// only the keys, the table is baked when loading
+				const TwkCurve* curve = ptr.curvePtr;
+				for (int j = 0; j < curve->count; ++j) {
+					if (j != 0) {
+						*p++ = ',';
+						*p++ = ' ';
+					}
+					p = twk__write_float(p, curve->keys[j]);
+				}
+				break;
+			}
+			default: {
+				// floats, vectors and arrays are consecutive floats
+				int count = twk__value_count(i);
+				for (int j = 0; j < count; ++j) {
+					if (j != 0) {
+						*p++ = ',';
+						*p++ = ' ';
+					}
+					p = twk__write_float(p, ptr.fPtr[j]);
+				}
+				break;
+			}
+		}
+		*p++ = '\n';
+		used = static_cast<size_t>(p - buffer->data());
+	}
+	if (used + 2 > buffer->size()) {
+		buffer->resize(used + 2);
+	}
+	if (currentCategory != -1) {
+		buffer->data()[used++] = '}';
+		buffer->data()[used++] = '\n';
+	}
+	return used;
+}
+
+// -------------------------------------------------------
+// internal write file atomically
+// Writes a temp file next to the target and renames it so a
+// crash or a reader never sees a half written file.
+// -------------------------------------------------------
+static bool twk__write_file_atomic(const char* fileName, const char* data, size_t size) {
+	char tempName[1024];
+	size_t l = strlen(fileName);
+	if (l + 5 > sizeof(tempName)) {
+		return false;
+	}
+	memcpy(tempName, fileName, l);
+	memcpy(tempName + l, ".tmp", 5);
+	FILE* fp = fopen(tempName, "wb");
+	if (fp == 0) {
+		return false;
+	}
+	bool success = fwrite(data, 1, size, fp) == size && fflush(fp) == 0;
+#ifndef _WIN32
+	success = success && fsync(fileno(fp)) == 0;
+#endif
+	success = fclose(fp) == 0 && success;
+#ifdef _WIN32
+	success = success && MoveFileExA(tempName, fileName, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	success = success && rename(tempName, fileName) == 0;
+#endif
+	if (!success) {
+		remove(tempName);
+	}
+	return success;
+}
+
+// -------------------------------------------------------
+// save
+// Writes all registered items so that parsing the file
+// gives back exactly the same values.
+// -------------------------------------------------------
+#ifndef TWK_DEFAULT_SAVE_FILE
+#define TWK_DEFAULT_SAVE_FILE "test.txt"
+#endif
+
+bool twk_save(TWKContext* ctx, const char* fileName) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	size_t size = twk__format_settings(&_twkCtx->saveBuffer);
+	if (!twk__write_file_atomic(fileName, _twkCtx->saveBuffer.data(), size)) {
+		twk__report_error("Cannot save file: '%s'", fileName);
+		return false;
+	}
+	return true;
+}
+
+bool twk_save(TWKContext* ctx) {
+	return twk_save(ctx, TWK_DEFAULT_SAVE_FILE);
+}
+
+// -------------------------------------------------------
+// internal file data
+// Files are read into a buffer which is reused across
+// reloads. With TWK_USE_MMAP large files are mapped and
+// parsed straight from the page cache instead. The parser is
+// bounded by the end pointer so the text does not need a
+// terminating zero. The vector paths use aligned loads which
+// never cross a page and therefore never leave the mapping.
+// A mapped file that is truncated while it is parsed raises
+// SIGBUS, so mapping is only safe for files that are not
+// rewritten in place.
+// -------------------------------------------------------
+#ifndef TWK_MMAP_MIN_SIZE
+#define TWK_MMAP_MIN_SIZE 65536
+#endif
+
+struct TWKFileData {
+	const char* data;
+	size_t size;
+	bool mapped;
+#ifdef _WIN32
+	HANDLE mapping;
+#endif
+};
+
+// -------------------------------------------------------
+// internal map file
+// -------------------------------------------------------
+static bool twk__map_file(const char* fileName, TWKFileData* file) {
+#ifndef TWK_USE_MMAP
+	(void)fileName;
+	(void)file;
+	return false;
+#elif defined(_WIN32)
+	// allow editors to replace the file while it is mapped
+	HANDLE hFile = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size) || size.QuadPart < TWK_MMAP_MIN_SIZE) {
+		CloseHandle(hFile);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(hFile);
+	if (mapping == NULL) {
+		return false;
+	}
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL) {
+		CloseHandle(mapping);
+		return false;
+	}
+	file->data = static_cast<const char*>(view);
+	file->size = static_cast<size_t>(size.QuadPart);
+	file->mapping = mapping;
+	file->mapped = true;
+	return true;
+#else
+	int fd = open(fileName, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < TWK_MMAP_MIN_SIZE) {
+		close(fd);
+		return false;
+	}
+	void* view = mmap(0, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	file->data = static_cast<const char*>(view);
+	file->size = static_cast<size_t>(st.st_size);
+	file->mapped = true;
+	return true;
+#endif
+}
+
+// -------------------------------------------------------
+// internal load file
+// Maps the file or reads it into buffer. Returns false if
+// the file cannot be opened.
+// -------------------------------------------------------
+static bool twk__load_file(const char* fileName, TWKVector<char>* buffer, TWKFileData* file) {
+	file->data = 0;
+	file->size = 0;
+	file->mapped = false;
+	if (twk__map_file(fileName, file)) {
+		return true;
+	}
+	FILE *fp = fopen(fileName, "rb");
+	if (fp) {
+		fseek(fp, 0, SEEK_END);
+		long sz = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		if (sz < 0) {
+			fclose(fp);
+			return false;
+		}
+		buffer->resize(static_cast<size_t>(sz) + 1);
+		size_t read = fread(buffer->data(), 1, static_cast<size_t>(sz), fp);
+		fclose(fp);
+		file->data = buffer->data();
+		file->size = read;
+		return true;
+	}
+	return false;
+}
+
+// -------------------------------------------------------
+// internal release file
+// -------------------------------------------------------
+static void twk__release_file(TWKFileData* file) {
+	if (file->mapped) {
+#ifdef _WIN32
+		UnmapViewOfFile(file->data);
+		CloseHandle(file->mapping);
+#else
+		munmap(const_cast<char*>(file->data), file->size);
+#endif
+		file->mapped = false;
+	}
+	file->data = 0;
+	file->size = 0;
+}
+
+/*
+ * The idea is taken from https://github.com/chadaustin/sajson/blob/master/include/sajson.h
+ * bit 1 = digit
+ * bit 2 = numeric
+ * bit 3 = name
+ * bit 4 = whitespace
+ * bit 5 = supported
+*/
+const uint8_t PARSE_FLAGS[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 0, 0, 8, 0, 0,  
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  
+	8, 0, 0,16, 0, 0, 0, 0,16,16,16, 1,16, 1, 1,16, 
+	3, 3, 3, 3, 3, 3, 3, 3, 3, 3,16, 0, 0, 0, 0, 0, 
+	0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 0, 0, 0,16, 4,
+	0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,16, 0,16, 0, 0,
+	// 128-255 -> we do not support any character >= 128
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static bool inline twk__is_supported(const char c) {
+	return (PARSE_FLAGS[static_cast<unsigned char>(c)]) > 0;
+}
+// -------------------------------------------------------
+// internal is digit
+// -------------------------------------------------------
+static bool  inline twk__is_digit(const char c) {
+	return (PARSE_FLAGS[static_cast<unsigned char>(c)] & 1) != 0;
+}
+
+// -------------------------------------------------------
+// internal is numeric
+// -------------------------------------------------------
+static bool  inline twk__is_numeric(const char c) {
+	return (PARSE_FLAGS[static_cast<unsigned char>(c)] & 2) != 0;
+}
+
+// -------------------------------------------------------
+// internal is name char
+// -------------------------------------------------------
+static bool  inline twk__is_name(const char c) {
+	return (PARSE_FLAGS[static_cast<unsigned char>(c)] & 4) != 0;
+}
+// -------------------------------------------------------
+// internal is whitespace
+// -------------------------------------------------------
+static bool  inline twk__is_whitespace(const char c) {
+	return (PARSE_FLAGS[static_cast<unsigned char>(c)] & 8) != 0;
+}
+
+// -------------------------------------------------------
+// vectorized character classification
+// The SSE2 / AVX2 paths classify 16 / 32 bytes per step and
+// must produce the same results as twk__is_whitespace,
+// twk__is_name and twk__is_digit. The path is selected once
+// at startup by CPU feature. Define TWK_NO_SIMD to always
+// use the scalar path.
+// -------------------------------------------------------
+enum TWKSimdLevel { TWK_SIMD_SCALAR, TWK_SIMD_SSE2, TWK_SIMD_AVX2 };
+
+#ifdef TWK_SIMD_X86
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TWK_TARGET_AVX2 __attribute__((target("avx2")))
+// the aligned block loads may touch bytes outside of the buffer but never cross a page
+#define TWK_NO_SANITIZE __attribute__((no_sanitize_address, no_sanitize_thread))
+#else
+#define TWK_TARGET_AVX2
+#define TWK_NO_SANITIZE
+#endif
+
+static inline int twk__ctz(uint32_t mask) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, mask);
+	return static_cast<int>(idx);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+static int twk__detect_simd() {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7) {
+		__cpuid(info, 1);
+		// OSXSAVE and AVX and the OS saves the YMM registers
+		bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+		__cpuidex(info, 7, 0);
+		if (osAvx && (info[1] & (1 << 5)) != 0) {
+			return TWK_SIMD_AVX2;
+		}
+	}
+	return TWK_SIMD_SSE2;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return TWK_SIMD_AVX2;
+	}
+	return TWK_SIMD_SSE2;
+#endif
+}
+
+static int _twkSimd = twk__detect_simd();
+
+// -------------------------------------------------------
+// SSE2 classification of 16 bytes -> one bit per byte
+// -------------------------------------------------------
+static inline uint32_t twk__whitespace_mask_sse2(__m128i v) {
+	__m128i r = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+	r = _mm_or_si128(r, _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+	r = _mm_or_si128(r, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+	return static_cast<uint32_t>(_mm_movemask_epi8(r));
+}
+
+static inline uint32_t twk__name_mask_sse2(__m128i v) {
+	// folding the case maps 'A'-'Z' onto 'a'-'z' - bytes >= 128 are negative and never match
+	__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	__m128i r = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+	r = _mm_or_si128(r, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+	return static_cast<uint32_t>(_mm_movemask_epi8(r));
+}
+
+static inline uint32_t twk__digit_mask_sse2(__m128i v) {
+	__m128i r = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+	r = _mm_or_si128(r, _mm_cmpeq_epi8(v, _mm_set1_epi8('+')));
+	r = _mm_or_si128(r, _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+	r = _mm_or_si128(r, _mm_cmpeq_epi8(v, _mm_set1_epi8('.')));
+	return static_cast<uint32_t>(_mm_movemask_epi8(r));
+}
+
+// -------------------------------------------------------
+// AVX2 classification of 32 bytes -> one bit per byte
+// -------------------------------------------------------
+TWK_TARGET_AVX2 static inline uint32_t twk__whitespace_mask_avx2(__m256i v) {
+	__m256i r = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+	r = _mm256_or_si256(r, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+	r = _mm256_or_si256(r, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+	return static_cast<uint32_t>(_mm256_movemask_epi8(r));
+}
+
+TWK_TARGET_AVX2 static inline uint32_t twk__name_mask_avx2(__m256i v) {
+	__m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+	__m256i r = _mm256_andnot_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8('a'), lower), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+	r = _mm256_or_si256(r, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+	return static_cast<uint32_t>(_mm256_movemask_epi8(r));
+}
+
+TWK_TARGET_AVX2 static inline uint32_t twk__digit_mask_avx2(__m256i v) {
+	__m256i r = _mm256_andnot_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8('0'), v), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+	r = _mm256_or_si256(r, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('+')));
+	r = _mm256_or_si256(r, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')));
+	r = _mm256_or_si256(r, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')));
+	return static_cast<uint32_t>(_mm256_movemask_epi8(r));
+}
+
+// -------------------------------------------------------
+// internal skip while the class mask is set
+// The loads are aligned so a block never crosses a page
+// boundary. Bytes in front of p are shifted out and a stop
+// found behind end is clamped to end.
+// -------------------------------------------------------
+TWK_NO_SANITIZE static const char* twk__skip_sse2(const char* p, const char* end, bool name) {
+	while (p < end) {
+		const char* base = reinterpret_cast<const char*>(reinterpret_cast<uintptr_t>(p) & ~static_cast<uintptr_t>(15));
+		__m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(base));
+		uint32_t mask = name ? twk__name_mask_sse2(v) : twk__whitespace_mask_sse2(v);
+		uint32_t stop = (~mask & 0xFFFF) >> (p - base);
+		if (stop != 0) {
+			p += twk__ctz(stop);
+			return p < end ? p : end;
+		}
+		p = base + 16;
+	}
+	return end;
+}
+
+TWK_TARGET_AVX2 TWK_NO_SANITIZE static const char* twk__skip_avx2(const char* p, const char* end, bool name) {
+	while (p < end) {
+		const char* base = reinterpret_cast<const char*>(reinterpret_cast<uintptr_t>(p) & ~static_cast<uintptr_t>(31));
+		__m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(base));
+		uint32_t mask = name ? twk__name_mask_avx2(v) : twk__whitespace_mask_avx2(v);
+		uint32_t stop = ~mask >> (p - base);
+		if (stop != 0) {
+			p += twk__ctz(stop);
+			return p < end ? p : end;
+		}
+		p = base + 32;
+	}
+	return end;
+}
+
+#else
+
+static int _twkSimd = TWK_SIMD_SCALAR;
+
+#endif
+
+// -------------------------------------------------------
+// internal bake curve
+// Samples the keys at TWK_CURVE_RESOLUTION evenly spaced
+// points between the first and the last key.
+// -------------------------------------------------------
+static void twk__bake_curve(TwkCurve* curve) {
+	int stride = curve->mode == TWK_CURVE_HERMITE ? 3 : 2;
+	int num = curve->count / stride;
+	const float* keys = curve->keys;
+	if (num == 0) {
+		curve->start = 0.0f;
+		curve->scale = 0.0f;
+		std::fill(curve->table, curve->table + TWK_CURVE_RESOLUTION + 1, 0.0f);
+		return;
+	}
+	float start = keys[0];
+	float end = keys[(num - 1) * stride];
+	curve->start = start;
+	curve->scale = end > start ? static_cast<float>(TWK_CURVE_RESOLUTION - 1) / (end - start) : 0.0f;
+	int segment = 0;
+	for (int i = 0; i < TWK_CURVE_RESOLUTION; ++i) {
+		float t = i == TWK_CURVE_RESOLUTION - 1 ? end : start + (end - start) * static_cast<float>(i) / static_cast<float>(TWK_CURVE_RESOLUTION - 1);
+		while (segment < num - 2 && t >= keys[(segment + 1) * stride]) {
+			++segment;
+		}
+		const float* k0 = keys + segment * stride;
+		const float* k1 = num > 1 ? k0 + stride : k0;
+		float dt = k1[0] - k0[0];
+		if (dt <= 0.0f) {
+			curve->table[i] = k1[1];
+			continue;
+		}
+		float s = (t - k0[0]) / dt;
+		s = s < 0.0f ? 0.0f : (s > 1.0f ? 1.0f : s);
+		if (stride == 2) {
+			curve->table[i] = k0[1] + s * (k1[1] - k0[1]);
+		}
+		else {
+			float s2 = s * s;
+			float s3 = s2 * s;
+			float h00 = 2.0f * s3 - 3.0f * s2 + 1.0f;
+			float h10 = s3 - 2.0f * s2 + s;
+			float h01 = -2.0f * s3 + 3.0f * s2;
+			float h11 = s3 - s2;
+			curve->table[i] = h00 * k0[1] + h10 * dt * k0[2] + h01 * k1[1] + h11 * dt * k1[2];
+		}
+	}
+	curve->table[TWK_CURVE_RESOLUTION] = curve->table[TWK_CURVE_RESOLUTION - 1];
+}
+
+// -------------------------------------------------------
+// internal set curve
+// Copies the keys and bakes the table. Returns false and
+// keeps the curve if the keys are not valid.
+// -------------------------------------------------------
+static bool twk__set_curve(TwkCurve* curve, const float* keys, int count) {
+	int stride = curve->mode == TWK_CURVE_HERMITE ? 3 : 2;
+	if (count != 0 && twk__convert(ST_CURVE, stride, keys, count, curve->keys) == 0) {
+		return false;
+	}
+	curve->count = count;
+	twk__bake_curve(curve);
+	return true;
+}
+
+// -------------------------------------------------------
+// curve evaluation
+// Every path computes table[i] + f * (table[i + 1] - table[i])
+// with the same operations so the results are identical.
+// -------------------------------------------------------
+static inline float twk__curve_sample(const TwkCurve& curve, float t) {
+	const float last = static_cast<float>(TWK_CURVE_RESOLUTION - 1);
+	float x = (t - curve.start) * curve.scale;
+	// NaN ends up at the start like in the vector paths
+	x = x > 0.0f ? x : 0.0f;
+	x = x < last ? x : last;
+	int i = static_cast<int>(x);
+	float f = x - static_cast<float>(i);
+	return curve.table[i] + f * (curve.table[i + 1] - curve.table[i]);
+}
+
+#ifdef TWK_SIMD_X86
+static int twk__curve_eval_sse2(const TwkCurve& curve, const float* t, float* out, int count) {
+	const __m128 start = _mm_set1_ps(curve.start);
+	const __m128 scale = _mm_set1_ps(curve.scale);
+	const __m128 last = _mm_set1_ps(static_cast<float>(TWK_CURVE_RESOLUTION - 1));
+	const __m128 zero = _mm_setzero_ps();
+	const float* table = curve.table;
+	int n = 0;
+	for (; n + 4 <= count; n += 4) {
+		__m128 x = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(t + n), start), scale);
+		x = _mm_min_ps(_mm_max_ps(x, zero), last);
+		__m128i i = _mm_cvttps_epi32(x);
+		__m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(i));
+		// SSE2 has no gather
+		int idx[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(idx), i);
+		__m128 a = _mm_setr_ps(table[idx[0]], table[idx[1]], table[idx[2]], table[idx[3]]);
+		__m128 b = _mm_setr_ps(table[idx[0] + 1], table[idx[1] + 1], table[idx[2] + 1], table[idx[3] + 1]);
+		_mm_storeu_ps(out + n, _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(b, a))));
+	}
+	return n;
+}
+
+TWK_TARGET_AVX2 static int twk__curve_eval_avx2(const TwkCurve& curve, const float* t, float* out, int count) {
+	const __m256 start = _mm256_set1_ps(curve.start);
+	const __m256 scale = _mm256_set1_ps(curve.scale);
+	const __m256 last = _mm256_set1_ps(static_cast<float>(TWK_CURVE_RESOLUTION - 1));
+	const __m256 zero = _mm256_setzero_ps();
+	int n = 0;
+	for (; n + 8 <= count; n += 8) {
+		__m256 x = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(t + n), start), scale);
+		x = _mm256_min_ps(_mm256_max_ps(x, zero), last);
+		__m256i i = _mm256_cvttps_epi32(x);
+		__m256 f = _mm256_sub_ps(x, _mm256_cvtepi32_ps(i));
+		__m256 a = _mm256_i32gather_ps(curve.table, i, 4);
+		__m256 b = _mm256_i32gather_ps(curve.table + 1, i, 4);
+		_mm256_storeu_ps(out + n, _mm256_add_ps(a, _mm256_mul_ps(f, _mm256_sub_ps(b, a))));
+	}
+	return n;
+}
+#endif
+
+float twk_curve_eval(const TwkCurve& curve, float t) {
+	return twk__curve_sample(curve, t);
+}
+
+void twk_curve_eval(const TwkCurve& curve, const float* t, float* out, int count) {
+	int n = 0;
+#ifdef TWK_SIMD_X86
+	if (_twkSimd == TWK_SIMD_AVX2) {
+		n = twk__curve_eval_avx2(curve, t, out, count);
+	}
+	else if (_twkSimd == TWK_SIMD_SSE2) {
+		n = twk__curve_eval_sse2(curve, t, out, count);
+	}
+#endif
+	for (; n < count; ++n) {
+		out[n] = twk__curve_sample(curve, t[n]);
+	}
+}
+
+// -------------------------------------------------------
+// internal skip whitespace
+// -------------------------------------------------------
+static inline const char* twk__skip_whitespace(const char* p, const char* end) {
+	// most runs are a single blank so check the first byte upfront
+	if (p >= end || !twk__is_whitespace(*p)) {
+		return p;
+	}
+#ifdef TWK_SIMD_X86
+	if (_twkSimd == TWK_SIMD_AVX2) {
+		return twk__skip_avx2(p + 1, end, false);
+	}
+	if (_twkSimd == TWK_SIMD_SSE2) {
+		return twk__skip_sse2(p + 1, end, false);
+	}
+#endif
+	++p;
+	while (p < end && twk__is_whitespace(*p)) {
+		++p;
+	}
+	return p;
+}
+
+// -------------------------------------------------------
+// internal skip name
+// -------------------------------------------------------
+static inline const char* twk__skip_name(const char* p, const char* end) {
+#ifdef TWK_SIMD_X86
+	if (_twkSimd == TWK_SIMD_AVX2) {
+		return twk__skip_avx2(p, end, true);
+	}
+	if (_twkSimd == TWK_SIMD_SSE2) {
+		return twk__skip_sse2(p, end, true);
+	}
+#endif
+	while (p < end && twk__is_name(*p)) {
+		++p;
+	}
+	return p;
+}
+
+// -------------------------------------------------------
+// internal string to float
+// The digits are collected as an integer mantissa and a
+// decimal exponent. When both are small enough the value is
+// exact in float or double arithmetic and a single correctly
+// rounded multiplication or division gives the result
+// (Clinger's fast path as used by fast_float). Everything
+// else, like very long mantissas or huge exponents, falls back
+// to strtof with the C locale so the result is always
+// correctly rounded and the decimal point is always '.'.
+// -------------------------------------------------------
+static const float TWK__POW10_F[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+static const double TWK__POW10_D[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const double TWK__POW10_INV_D[] = {
+	1e-0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9, 1e-10, 1e-11,
+	1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18, 1e-19, 1e-20, 1e-21, 1e-22
+};
+
+static float twk__strtof_c(const char* str) {
+#ifdef _WIN32
+	static _locale_t locale = _create_locale(LC_NUMERIC, "C");
+	return _strtof_l(str, 0, locale);
+#else
+	static locale_t locale = newlocale(LC_NUMERIC_MASK, "C", static_cast<locale_t>(0));
+	return strtof_l(str, 0, locale);
+#endif
+}
+
+static float twk__strtof_fallback(const char* start, const char* stop, const char* end) {
+	char buffer[128];
+	size_t l = static_cast<size_t>(stop - start);
+	if (l >= sizeof(buffer)) {
+		if (stop < end) {
+			// strtof stops at the same character as the scan above
+			return twk__strtof_c(start);
+		}
+		// the literal ends the input and is too long for the buffer
+		char* copy = static_cast<char*>(twk__alloc(l + 1));
+		memcpy(copy, start, l);
+		copy[l] = '\0';
+		float value = twk__strtof_c(copy);
+		twk__free(copy);
+		return value;
+	}
+	memcpy(buffer, start, l);
+	buffer[l] = '\0';
+	return twk__strtof_c(buffer);
+}
+
+struct TWKDecimal {
+	uint64_t mantissa;
+	int exponent;
+	int digits;
+	bool negative;
+};
+
+// -------------------------------------------------------
+// internal scan sign, integer and fraction digits
+// -------------------------------------------------------
+static inline const char* twk__scan_decimal(const char* p, const char* end, TWKDecimal* decimal) {
+	decimal->negative = false;
+	if (p < end && *p == '-') {
+		decimal->negative = true;
+		++p;
+	}
+	else if (p < end && *p == '+') {
+		++p;
+	}
+	uint64_t mantissa = 0;
+	uint32_t digit;
+	const char* digits = p;
+	while (p < end && (digit = static_cast<unsigned char>(*p) - '0') <= 9) {
+		mantissa = mantissa * 10 + digit;
+		++p;
+	}
+	int numDigits = static_cast<int>(p - digits);
+	int exponent = 0;
+	if (p < end && *p == '.') {
+		++p;
+		digits = p;
+		while (p < end && (digit = static_cast<unsigned char>(*p) - '0') <= 9) {
+			mantissa = mantissa * 10 + digit;
+			++p;
+		}
+		exponent = -static_cast<int>(p - digits);
+		numDigits -= exponent;
+	}
+	decimal->mantissa = mantissa;
+	decimal->exponent = exponent;
+	decimal->digits = numDigits;
+	return p;
+}
+
+// -------------------------------------------------------
+// internal exponent, exact fast paths and strtof fallback
+// Scans the number again so the common path can keep
+// everything in registers.
+// -------------------------------------------------------
+TWK_NOINLINE static float twk__strtof_slow(const char* start, const char* end, const char** endPtr) {
+	TWKDecimal number;
+	TWKDecimal* decimal = &number;
+	const char* p = twk__scan_decimal(start, end, decimal);
+	// the exponent is only consumed when digits follow - "1e" stays a number and a name
+	if (p + 1 < end && (*p | 0x20) == 'e') {
+		const char* e = p + 1;
+		bool negativeExponent = false;
+		if (*e == '-' || *e == '+') {
+			negativeExponent = *e == '-';
+			++e;
+		}
+		if (e < end && twk__is_numeric(*e)) {
+			int value = 0;
+			while (e < end && twk__is_numeric(*e)) {
+				if (value < 100000) {
+					value = value * 10 + (*e - '0');
+				}
+				++e;
+			}
+			decimal->exponent += negativeExponent ? -value : value;
+			p = e;
+		}
+	}
+	if (endPtr) {
+		*endPtr = p;
+	}
+	// more than 19 digits might have overflowed the mantissa
+	if (decimal->digits <= 19) {
+		uint64_t mantissa = decimal->mantissa;
+		int exponent = decimal->exponent;
+		if (mantissa == 0) {
+			return decimal->negative ? -0.0f : 0.0f;
+		}
+		if (mantissa <= (1ull << 24) && exponent >= -10 && exponent <= 10) {
+			float value = static_cast<float>(static_cast<int64_t>(mantissa));
+			value = exponent < 0 ? value / TWK__POW10_F[-exponent] : value * TWK__POW10_F[exponent];
+			return decimal->negative ? -value : value;
+		}
+		if (mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22) {
+			double value = static_cast<double>(static_cast<int64_t>(mantissa));
+			value = exponent < 0 ? value / TWK__POW10_D[-exponent] : value * TWK__POW10_D[exponent];
+			// rounding the double to float again is only wrong if it hits a float midpoint
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			if ((bits & 0x1FFFFFFF) != 0x10000000) {
+				float f = static_cast<float>(value);
+				return decimal->negative ? -f : f;
+			}
+		}
+	}
+	return twk__strtof_fallback(start, p, end);
+}
+
+static float twk__strtof(const char* p, const char* end, const char** endPtr) {
+	while (p < end && twk__is_whitespace(*p)) {
+		++p;
+	}
+	const char* start = p;
+	TWKDecimal decimal;
+	p = twk__scan_decimal(p, end, &decimal);
+	// without an exponent the decimal exponent is never positive
+	if ((p >= end || (*p | 0x20) != 'e') && decimal.digits <= 19 && decimal.mantissa <= (1ull << 53) && decimal.exponent >= -22) {
+		// multiplying with the rounded reciprocal is off by at most two double ulps
+		// which only matters if the result is that close to a float midpoint
+		double value = static_cast<double>(static_cast<int64_t>(decimal.mantissa)) * TWK__POW10_INV_D[-decimal.exponent];
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		if (static_cast<uint32_t>((bits & 0x1FFFFFFF) - (0x10000000 - 8)) > 16) {
+			if (endPtr) {
+				*endPtr = p;
+			}
+			float f = static_cast<float>(value);
+			return decimal.negative ? -f : f;
+		}
+	}
+	return twk__strtof_slow(start, end, endPtr);
+}
+
+// -------------------------------------------------------
+// internal include directive
+// @include "file" - the token covers the text between the
+// quotes. Returns 0 if p does not start a valid directive.
+// -------------------------------------------------------
+static const char* twk__scan_include(const char* text, const char* p, const char* end, TWKToken* token) {
+	if (end - p < 8 || memcmp(p, "@include", 8) != 0) {
+		return 0;
+	}
+	const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+	const char* lineEnd = nl != 0 ? nl : end;
+	const char* open = static_cast<const char*>(memchr(p + 8, '"', lineEnd - p - 8));
+	if (open == 0) {
+		return 0;
+	}
+	const char* close = static_cast<const char*>(memchr(open + 1, '"', lineEnd - open - 1));
+	if (close == 0 || close == open + 1) {
+		return 0;
+	}
+	token->type = TWKToken::INCLUDE;
+	token->index = static_cast<int>(open + 1 - text);
+	token->size = static_cast<int>(close - open - 1);
+	return close + 1;
+}
+
+// -------------------------------------------------------
+// internal next token
+// Returns the position after the token. Whitespace, comments
+// and unsupported characters are skipped. The token type is
+// EMPTY once the end of the input has been reached.
+// -------------------------------------------------------
+static const char* twk__next_token(const char* text, const char* p, const char* end, TWKToken* token) {
+	token->type = TWKToken::EMPTY;
+	while (p < end) {
+		const char c = *p;
+		if (twk__is_whitespace(c)) {
+			p = twk__skip_whitespace(p, end);
+		}
+		else if (c == '@') {
+			const char* next = twk__scan_include(text, p, end, token);
+			if (next != 0) {
+				return next;
+			}
+			++p;
+		}
+		else if (!twk__is_supported(c)) {
+			++p;
+		}
+		else if (twk__is_digit(c)) {
+			// a sign without a number behind it is the operator of an expression
+			if ((c == '-' || c == '+') && (p + 1 >= end || (!twk__is_numeric(p[1]) && p[1] != '.'))) {
+				token->type = TWKToken::OPERATOR;
+				return p + 1;
+			}
+			token->type = TWKToken::NUMBER;
+			token->value = twk__strtof(p, end, &p);
+			return p;
+		}
+		else if (twk__is_name(c)) {
+			const char *identifier = p;
+			p = twk__skip_name(p, end);
+			token->type = TWKToken::NAME;
+			token->index = static_cast<int>(identifier - text);
+			token->size = static_cast<int>(p - identifier);
+			return p;
+		}
+		else if (c == '#') {
+			const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+			p = nl != 0 ? nl : end;
+		}
+		else {
+			switch (c) {
+				case '{': token->type = TWKToken::OPEN_BRACES; break;
+				case '}': token->type = TWKToken::CLOSE_BRACES; break;
+				case ':': token->type = TWKToken::ASSIGN; break;
+				case ',': token->type = TWKToken::DELIMITER; break;
+				case '(': case ')': case '*': case '/': token->type = TWKToken::OPERATOR; break;
+			}
+			++p;
+			if (token->type != TWKToken::EMPTY) {
+				return p;
+			}
+		}
+	}
+	return p;
+}
+
+// -------------------------------------------------------
+// internal find item of a file
+// twk_save writes the keys of a category in the order they
+// were registered. So the item after the previous key is
+// tried first and the index is only probed if it does not
+// match. A reload of a large file then walks the item arrays
+// in order instead of missing the cache on every probe.
+// The check of the next item counts as one probe.
+// -------------------------------------------------------
+static int twk__find_next_item(int categoryIndex, const char* name, size_t length, uint32_t nameHash, int* next, uint32_t* probes) {
+	int idx = *next;
+	++*probes;
+	if (idx < 0 || static_cast<size_t>(idx) >= twk__num_items() || _twkCtx->items.hashes[idx] != nameHash || !twk__item_is(idx, categoryIndex, name, length)) {
+		idx = twk__find_item(categoryIndex, name, length, nameHash, probes);
+	}
+	*next = idx + 1;
+	return idx;
+}
+
+// -------------------------------------------------------
+// internal find variable
+// -------------------------------------------------------
+static int twk__find(int categoryIndex, const char* name) {
+	size_t length = strlen(name);
+	return twk__find_item(categoryIndex, name, length, twk__fnv1a(name, length));
+}
+
+// -------------------------------------------------------
+// internal convert value
+// Converts the parsed values into the memory layout of the
+// item. Returns the number of 4 byte values written to out
+// or 0 if the values do not match the type of the item.
+// out may point to values.
+// -------------------------------------------------------
+static int twk__convert_value(int index, const float* values, int count, float* out) {
+	return twk__convert(static_cast<TweakableType>(_twkCtx->items.types[index]), _twkCtx->items.info[index].arrayLength, values, count, out);
+}
+
+// -------------------------------------------------------
+// internal changed list
+// Every item is recorded only once until the list is
+// cleared again.
+// -------------------------------------------------------
+static void twk__clear_changed() {
+	_twkCtx->changedItems.clear();
+	++_twkCtx->changedStamp;
+}
+
+static void twk__mark_changed(int index) {
+	TWKItemInfo& info = _twkCtx->items.info[index];
+	if (info.changedStamp != _twkCtx->changedStamp) {
+		info.changedStamp = _twkCtx->changedStamp;
+		_twkCtx->changedItems.push_back(index);
+	}
+}
+
+// -------------------------------------------------------
+// internal write value
+// Copies the converted values into the item and records it
+// as changed if they differ from the current ones.
+// -------------------------------------------------------
+static void twk__write_value(int index, const float* values, int count) {
+	if (_twkCtx->items.types[index] == ST_CURVE) {
+		// the table is only baked again if the keys changed
+		TwkCurve* curve = _twkCtx->items.ptrs[index].curvePtr;
+		if (curve->count != count || memcmp(curve->keys, values, count * sizeof(float)) != 0) {
+			twk__set_curve(curve, values, count);
+			twk__mark_changed(index);
+		}
+	}
+	else {
+		float* ptr = _twkCtx->items.ptrs[index].fPtr;
+		if (memcmp(ptr, values, count * sizeof(float)) != 0) {
+			memcpy(ptr, values, count * sizeof(float));
+			twk__mark_changed(index);
+		}
+	}
+	_twkCtx->items.found[index] = 1;
+	_twkCtx->items.setGenerations[index] = _twkCtx->generation;
+}
+
+// -------------------------------------------------------
+// internal invalidate all category hashes
+// Values written by anything else than twk__parse no longer
+// match the hashed text.
+// -------------------------------------------------------
+static void twk__invalidate_categories() {
+	for (size_t i = 0; i < _twkCtx->categories.size(); ++i) {
+		_twkCtx->categories[i].hashValid = false;
+	}
+}
+
+// -------------------------------------------------------
+// internal expression compiler
+// Recursive descent over a single line:
+//   list      = sum { ',' sum }
+//   sum       = product { ('+' | '-') product }
+//   product   = unary { ('*' | '/') unary }
+//   unary     = ('-' | '+') unary | primary
+//   primary   = number | reference | '(' sum ')'
+//   reference = name | category '.' name
+// Every sum of the list ends with a store of its value. The
+// references are appended to refs starting at firstRef.
+// -------------------------------------------------------
+struct TWKExprCompiler {
+	const char* p;
+	const char* end;
+	uint32_t categoryHash;
+	TWKVector<TWKExprOp>* ops;
+	TWKVector<uint64_t>* refs;
+	int firstRef;
+	int depth;
+	bool failed;
+};
+
+static void twk__expr_sum(TWKExprCompiler* c);
+
+static inline void twk__expr_skip(TWKExprCompiler* c) {
+	while (c->p < c->end && *c->p != '\n' && twk__is_whitespace(*c->p)) {
+		++c->p;
+	}
+}
+
+static void twk__expr_op(TWKExprCompiler* c, int code, int ref, float value) {
+	TWKExprOp op;
+	op.code = code;
+	op.ref = ref;
+	op.value = value;
+	c->ops->push_back(op);
+}
+
+static void twk__expr_reference(TWKExprCompiler* c) {
+	const char* start = c->p;
+	c->p = twk__skip_name(c->p, c->end);
+	uint32_t categoryHash = c->categoryHash;
+	uint32_t nameHash = 0;
+	if (c->end - c->p > 1 && *c->p == '.' && twk__is_name(c->p[1])) {
+		categoryHash = twk__fnv1a(start, c->p - start);
+		start = ++c->p;
+		c->p = twk__skip_name(c->p, c->end);
+	}
+	nameHash = twk__fnv1a(start, c->p - start);
+	uint64_t key = twk__make_key(categoryHash, nameHash);
+	int numRefs = static_cast<int>(c->refs->size()) - c->firstRef;
+	int slot = 0;
+	while (slot < numRefs && (*c->refs)[c->firstRef + slot] != key) {
+		++slot;
+	}
+	if (slot == numRefs) {
+		if (numRefs == TWK_EXPR_MAX_REFS) {
+			c->failed = true;
+			return;
+		}
+		c->refs->push_back(key);
+	}
+	twk__expr_op(c, TWK_OP_REF, slot, 0.0f);
+}
+
+static void twk__expr_unary(TWKExprCompiler* c) {
+	twk__expr_skip(c);
+	// the nesting also limits the recursion
+	if (c->failed || c->p >= c->end || c->depth == TWK_EXPR_MAX_STACK) {
+		c->failed = true;
+		return;
+	}
+	char ch = *c->p;
+	if (ch == '-' || ch == '+') {
+		++c->p;
+		++c->depth;
+		twk__expr_unary(c);
+		--c->depth;
+		if (ch == '-') {
+			twk__expr_op(c, TWK_OP_NEG, 0, 0.0f);
+		}
+	}
+	else if (ch == '(') {
+		++c->p;
+		++c->depth;
+		twk__expr_sum(c);
+		--c->depth;
+		twk__expr_skip(c);
+		if (c->p >= c->end || *c->p != ')') {
+			c->failed = true;
+			return;
+		}
+		++c->p;
+	}
+	else if (twk__is_numeric(ch) || ch == '.') {
+		twk__expr_op(c, TWK_OP_CONST, 0, twk__strtof(c->p, c->end, &c->p));
+	}
+	else if (twk__is_name(ch)) {
+		twk__expr_reference(c);
+	}
+	else {
+		c->failed = true;
+	}
+}
+
+static void twk__expr_product(TWKExprCompiler* c) {
+	twk__expr_unary(c);
+	for (;;) {
+		twk__expr_skip(c);
+		if (c->failed || c->p >= c->end || (*c->p != '*' && *c->p != '/')) {
+			return;
+		}
+		int code = *c->p++ == '*' ? TWK_OP_MUL : TWK_OP_DIV;
+		twk__expr_unary(c);
+		twk__expr_op(c, code, 0, 0.0f);
+	}
+}
+
+static void twk__expr_sum(TWKExprCompiler* c) {
+	twk__expr_product(c);
+	for (;;) {
+		twk__expr_skip(c);
+		if (c->failed || c->p >= c->end || (*c->p != '+' && *c->p != '-')) {
+			return;
+		}
+		int code = *c->p++ == '+' ? TWK_OP_ADD : TWK_OP_SUB;
+		twk__expr_product(c);
+		twk__expr_op(c, code, 0, 0.0f);
+	}
+}
+
+static bool twk__expr_assignment(const char* p, const char* end) {
+	if (!twk__is_name(*p)) {
+		return false;
+	}
+	p = twk__skip_name(p, end);
+	while (p < end && *p != '\n' && twk__is_whitespace(*p)) {
+		++p;
+	}
+	return p < end && *p == ':';
+}
+
+// -------------------------------------------------------
+// internal compile expression
+// Appends the program and the references of the line that
+// starts at p. Returns the end of the line, the closing
+// brace or the next assignment of a single line block. On an error nothing is
+// appended and valid is set to false.
+// -------------------------------------------------------
+static const char* twk__compile_expression(const char* p, const char* end, uint32_t categoryHash, TWKVector<TWKExprOp>* ops, TWKVector<uint64_t>* refs, bool* valid) {
+	size_t firstOp = ops->size();
+	TWKExprCompiler c = { p, end, categoryHash, ops, refs, static_cast<int>(refs->size()), 0, false };
+	int count = 0;
+	for (;;) {
+		twk__expr_sum(&c);
+		twk__expr_op(&c, TWK_OP_STORE, 0, 0.0f);
+		++count;
+		twk__expr_skip(&c);
+		if (c.failed || c.p >= c.end || *c.p != ',') {
+			break;
+		}
+		++c.p;
+	}
+	// a single line block continues with the next assignment
+	if (c.p < c.end && *c.p != '\n' && *c.p != '#' && *c.p != '}' && !twk__expr_assignment(c.p, c.end)) {
+		c.failed = true;
+	}
+	// the stack depth is checked once here so the evaluation does not have to
+	int depth = 0;
+	for (size_t i = firstOp; i < ops->size() && !c.failed; ++i) {
+		int code = (*ops)[i].code;
+		depth += code == TWK_OP_CONST || code == TWK_OP_REF ? 1 : (code == TWK_OP_NEG ? 0 : -1);
+		c.failed = depth >= TWK_EXPR_MAX_STACK;
+	}
+	*valid = !c.failed && count <= 128;
+	if (!*valid) {
+		ops->resize(firstOp);
+		refs->resize(c.firstRef);
+		const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+		return nl != 0 ? nl : end;
+	}
+	return c.p;
+}
+
+// -------------------------------------------------------
+// internal evaluate expression
+// Returns the number of values written to out.
+// -------------------------------------------------------
+static int twk__eval_expression(const TWKExprOp* ops, int numOps, const float* inputs, float* out) {
+	float stack[TWK_EXPR_MAX_STACK];
+	int top = 0;
+	int count = 0;
+	for (int i = 0; i < numOps; ++i) {
+		const TWKExprOp& op = ops[i];
+		switch (op.code) {
+			case TWK_OP_CONST: stack[top++] = op.value; break;
+			case TWK_OP_REF: stack[top++] = inputs[op.ref]; break;
+			case TWK_OP_ADD: --top; stack[top - 1] += stack[top]; break;
+			case TWK_OP_SUB: --top; stack[top - 1] -= stack[top]; break;
+			case TWK_OP_MUL: --top; stack[top - 1] *= stack[top]; break;
+			case TWK_OP_DIV: --top; stack[top - 1] /= stack[top]; break;
+			case TWK_OP_NEG: stack[top - 1] = -stack[top - 1]; break;
+			case TWK_OP_STORE: out[count++] = stack[--top]; break;
+		}
+	}
+	return count;
+}
+
+// -------------------------------------------------------
+// internal derived range
+// Reuses the range as long as count does not grow.
+// -------------------------------------------------------
+template<class T>
+static void twk__derived_range(TWKVector<T>* data, int* offset, int* capacity, int count) {
+	if (count > *capacity) {
+		*offset = static_cast<int>(data->size());
+		*capacity = count;
+		data->resize(data->size() + count);
+	}
+}
+
+// -------------------------------------------------------
+// internal add derived
+// Stores the expression of a key. The program is only
+// replaced and the order only sorted again if the text of
+// the expression changed. Must be called while holding the
+// lock.
+// -------------------------------------------------------
+static void twk__add_derived(int categoryIndex, const char* name, size_t length, uint32_t nameHash, uint64_t hash, const TWKExprOp* ops, int numOps, const uint64_t* refs, int numRefs) {
+	TWKDerivedStore& store = _twkCtx->derived;
+	uint64_t key = twk__make_key(_twkCtx->categories[categoryIndex].hash, nameHash);
+	int idx = twk__index_find(&store.index, key);
+	if (idx == -1) {
+		TWKDerived d;
+		memset(&d, 0, sizeof(TWKDerived));
+		d.key = key;
+		d.category = categoryIndex;
+		d.nameIndex = twk__add_string(name, length, nameHash);
+		idx = static_cast<int>(store.entries.size());
+		store.entries.push_back(d);
+		twk__index_add(&store.index, key, idx);
+	}
+	TWKDerived& d = store.entries[idx];
+	if (d.numOps == 0 || d.hash != hash) {
+		twk__derived_range(&store.ops, &d.firstOp, &d.opCapacity, numOps);
+		memcpy(store.ops.data() + d.firstOp, ops, numOps * sizeof(TWKExprOp));
+		d.numOps = numOps;
+		twk__derived_range(&store.refs, &d.firstRef, &d.refCapacity, numRefs);
+		if (store.inputs.size() < store.refs.size()) {
+			store.inputs.resize(store.refs.size());
+		}
+		if (numRefs > 0) {
+			memcpy(store.refs.data() + d.firstRef, refs, numRefs * sizeof(uint64_t));
+		}
+		d.numRefs = numRefs;
+		d.hash = hash;
+		d.valid = 0;
+		store.sorted = false;
+	}
+	d.found = 1;
+	d.seenGeneration = _twkCtx->generation;
+}
+
+// -------------------------------------------------------
+// internal derived override
+// A constant that is assigned after an expression replaces
+// it like any later assignment of a key.
+// -------------------------------------------------------
+static void twk__derived_override(uint64_t key) {
+	TWKDerivedStore& store = _twkCtx->derived;
+	if (store.index.count == 0) {
+		return;
+	}
+	int idx = twk__index_find(&store.index, key);
+	if (idx != -1) {
+		store.entries[idx].found = 0;
+		store.entries[idx].seenGeneration = -1;
+	}
+}
+
+// -------------------------------------------------------
+// internal sort derived
+// Depth first search over the found derived values that
+// appends every one after its inputs. The stack holds pairs
+// of entry and next reference. Values on a cycle are marked
+// and never evaluated.
+// -------------------------------------------------------
+static void twk__sort_derived() {
+	TWKDerivedStore& store = _twkCtx->derived;
+	TWKVector<TWKDerived>& entries = store.entries;
+	TWKVector<int>& stack = store.stack;
+	store.order.clear();
+	for (size_t i = 0; i < entries.size(); ++i) {
+		entries[i].mark = 0;
+		entries[i].cyclic = 0;
+		entries[i].sortedFound = entries[i].found;
+	}
+	for (size_t i = 0; i < entries.size(); ++i) {
+		if (entries[i].found == 0 || entries[i].mark != 0) {
+			continue;
+		}
+		entries[i].mark = 1;
+		stack.push_back(static_cast<int>(i));
+		stack.push_back(0);
+		while (!stack.empty()) {
+			int top = static_cast<int>(stack.size()) - 2;
+			TWKDerived& d = entries[stack[top]];
+			if (stack[top + 1] == d.numRefs) {
+				d.mark = 2;
+				store.order.push_back(stack[top]);
+				stack.resize(top);
+				continue;
+			}
+			uint64_t ref = store.refs[d.firstRef + stack[top + 1]++];
+			int dep = twk__index_find(&store.index, ref);
+			if (dep == -1 || entries[dep].found == 0) {
+				continue;
+			}
+			if (entries[dep].mark == 1) {
+				// every value from the input up to this one is on the cycle
+				for (int j = top; j >= 0; j -= 2) {
+					entries[stack[j]].cyclic = 1;
+					if (stack[j] == dep) {
+						break;
+					}
+				}
+			}
+			else if (entries[dep].mark == 0) {
+				entries[dep].mark = 1;
+				stack.push_back(dep);
+				stack.push_back(0);
+			}
+		}
+	}
+	store.sorted = true;
+}
+
+// -------------------------------------------------------
+// internal derived input
+// Reads a scalar from the registered item or the pool.
+// -------------------------------------------------------
+static bool twk__derived_input(uint64_t key, float* value) {
+	int idx = twk__find_item(key);
+	if (idx != -1) {
+		const TWKValuePtr& ptr = _twkCtx->items.ptrs[idx];
+		switch (_twkCtx->items.types[idx]) {
+			case ST_FLOAT: *value = *ptr.fPtr; return true;
+			case ST_INT: *value = static_cast<float>(*ptr.iPtr); return true;
+			case ST_UINT: *value = static_cast<float>(*ptr.uiPtr); return true;
+			default: return false;
+		}
+	}
+	const TWKPoolEntry* entry = twk__pool_find(key);
+	if (entry == 0 || entry->count != 1) {
+		return false;
+	}
+	*value = _twkCtx->pool.values[entry->offset];
+	return true;
+}
+
+// -------------------------------------------------------
+// internal evaluate derived
+// Walks the found derived values in dependency order. A
+// value is only evaluated again if its expression changed
+// or one of its inputs differs from the last evaluation,
+// otherwise the stored result is written again so the key
+// stays found. Results go through the same conversion as
+// the values of the file. Must be called while holding the
+// lock.
+// -------------------------------------------------------
+static void twk__evaluate_derived() {
+	TWKDerivedStore& store = _twkCtx->derived;
+	TWKVector<TWKDerived>& entries = store.entries;
+	for (size_t i = 0; i < entries.size() && store.sorted; ++i) {
+		store.sorted = entries[i].found == entries[i].sortedFound;
+	}
+	if (!store.sorted) {
+		twk__sort_derived();
+	}
+	TwkReloadStats& stats = _twkCtx->reload.stats;
+	float inputs[TWK_EXPR_MAX_REFS];
+	float converted[128];
+	for (size_t o = 0; o < store.order.size(); ++o) {
+		TWKDerived& d = entries[store.order[o]];
+		d.evaluated = 0;
+		if (d.cyclic) {
+			twk__report_error("Cyclic reference in '%s'", twk__get_string(d.nameIndex));
+			continue;
+		}
+		bool ready = true;
+		for (int r = 0; r < d.numRefs && ready; ++r) {
+			uint64_t ref = store.refs[d.firstRef + r];
+			int dep = twk__index_find(&store.index, ref);
+			if (dep != -1 && entries[dep].found != 0 && entries[dep].evaluated == 0) {
+				// the input could not be evaluated either, it already reported why
+				ready = false;
+			}
+			else if (!twk__derived_input(ref, &inputs[r])) {
+				twk__report_error("Cannot resolve the references of '%s'", twk__get_string(d.nameIndex));
+				ready = false;
+			}
+		}
+		if (!ready) {
+			continue;
+		}
+		float* cached = store.inputs.data() + d.firstRef;
+		if (d.valid == 0 || (d.numRefs > 0 && memcmp(cached, inputs, d.numRefs * sizeof(float)) != 0)) {
+			if (d.numRefs > 0) {
+				memcpy(cached, inputs, d.numRefs * sizeof(float));
+			}
+			float values[128];
+			int count = twk__eval_expression(store.ops.data() + d.firstOp, d.numOps, inputs, values);
+			twk__derived_range(&store.values, &d.firstValue, &d.valueCapacity, count);
+			memcpy(store.values.data() + d.firstValue, values, count * sizeof(float));
+			d.numValues = count;
+			d.valid = 1;
+			++stats.derivedEvaluated;
+		}
+		d.evaluated = 1;
+		const float* values = store.values.data() + d.firstValue;
+		int idx = twk__find_item(d.category, twk__get_string(d.nameIndex), _twkCtx->strings.lengths[d.nameIndex], static_cast<uint32_t>(d.key));
+		if (idx != -1) {
+			int count = twk__convert_value(idx, values, d.numValues, converted);
+			if (count > 0) {
+				twk__write_value(idx, converted, count);
+				++stats.keysApplied;
+			}
+		}
+		else {
+			twk__pool_set(d.category, d.key, values, d.numValues);
+		}
+	}
+}
+
+// -------------------------------------------------------
+// internal update derived found after an incremental parse
+// Follows the same rules as the items.
+// -------------------------------------------------------
+static void twk__update_derived_found() {
+	int generation = _twkCtx->generation;
+	TWKVector<TWKDerived>& entries = _twkCtx->derived.entries;
+	for (size_t i = 0; i < entries.size(); ++i) {
+		TWKDerived& d = entries[i];
+		const TWKCategory& cat = _twkCtx->categories[d.category];
+		if (cat.seenGeneration != generation) {
+			d.found = 0;
+		}
+		else {
+			d.found = d.seenGeneration == generation || (cat.skippedGeneration == generation && d.found != 0);
+		}
+	}
+}
+
+// -------------------------------------------------------
+// internal set value
+// -------------------------------------------------------
+static void twk__set_value(int categoryIndex, const char* name, int length, uint32_t nameHash, float* values, int count) {
+	if (categoryIndex == -1) {
+		return;
+	}
+	TwkReloadStats& stats = _twkCtx->reload.stats;
+	uint64_t key = twk__make_key(_twkCtx->categories[categoryIndex].hash, nameHash);
+	twk__derived_override(key);
+	int idx = twk__find_next_item(categoryIndex, name, length, nameHash, &_twkCtx->nextItem, &stats.lookupProbes);
+	if (idx != -1) {
+		_twkCtx->items.info[idx].length = length;
+		int converted = twk__convert_value(idx, values, count, values);
+		if (converted > 0) {
+			twk__write_value(idx, values, converted);
+			++stats.keysApplied;
+		}
+	}
+	else {
+		++stats.lookupMisses;
+		twk__pool_set(categoryIndex, key, values, count);
+	}
+}
+
+// -------------------------------------------------------
+// internal check if the file should be (re)loaded
+// -------------------------------------------------------
+static bool twk__requires_loading() {
+	if (!_twkCtx->loaded) {
+		return true;
+	}
+	return twk__watch_changed(&_twkCtx->watch, _twkCtx->fileName);
+}
+
+// -------------------------------------------------------
+// internal reset found to false for every item, every
+// value of the pool and every derived value
+// -------------------------------------------------------
+static void twk__reset_found() {
+	std::fill(_twkCtx->items.found.begin(), _twkCtx->items.found.end(), 0);
+	TWKVector<TWKPoolEntry>& entries = _twkCtx->pool.entries;
+	for (size_t i = 0; i < entries.size(); ++i) {
+		entries[i].found = 0;
+	}
+	TWKVector<TWKDerived>& derived = _twkCtx->derived.entries;
+	for (size_t i = 0; i < derived.size(); ++i) {
+		derived[i].found = 0;
+	}
+}
+
+// -------------------------------------------------------
+// internal update found after an incremental parse
+// Items of skipped blocks keep their state, items of parsed
+// blocks are found if they were set by this parse and items
+// of categories that are no longer in the text are missing.
+// -------------------------------------------------------
+static void twk__update_found() {
+	int generation = _twkCtx->generation;
+	TWKItemStore& items = _twkCtx->items;
+	const TWKCategory* categories = _twkCtx->categories.data();
+	size_t num = twk__num_items();
+	for (size_t i = 0; i < num; ++i) {
+		const TWKCategory& cat = categories[items.categories[i]];
+		if (cat.seenGeneration != generation) {
+			items.found[i] = 0;
+		}
+		else {
+			items.found[i] = items.setGenerations[i] == generation || (cat.skippedGeneration == generation && items.found[i] != 0);
+		}
+	}
+	TWKVector<TWKPoolEntry>& entries = _twkCtx->pool.entries;
+	for (size_t i = 0; i < entries.size(); ++i) {
+		TWKPoolEntry& entry = entries[i];
+		const TWKCategory& cat = categories[entry.category];
+		if (cat.seenGeneration != generation) {
+			entry.found = 0;
+		}
+		else {
+			entry.found = entry.setGeneration == generation || (cat.skippedGeneration == generation && entry.found != 0);
+		}
+	}
+}
+
+// -------------------------------------------------------
+// internal find the end of a category block
+// Returns the closing brace that is not part of a comment.
+// -------------------------------------------------------
+static const char* twk__find_block_end(const char* p, const char* end) {
+	for (;;) {
+		const char* close = static_cast<const char*>(memchr(p, '}', end - p));
+		if (close == 0) {
+			return end;
+		}
+		const char* comment = static_cast<const char*>(memchr(p, '#', close - p));
+		if (comment == 0) {
+			return close;
+		}
+		const char* nl = static_cast<const char*>(memchr(comment, '\n', end - comment));
+		if (nl == 0) {
+			return end;
+		}
+		p = nl;
+	}
+}
+
+// -------------------------------------------------------
+// internal hash of a block of text
+// -------------------------------------------------------
+static uint64_t twk__hash_block(const char* p, const char* end) {
+	uint64_t h = 0x9E3779B97F4A7C15ULL ^ static_cast<uint64_t>(end - p);
+	while (end - p >= 8) {
+		uint64_t v;
+		memcpy(&v, p, 8);
+		h = (h ^ v) * 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 32;
+		p += 8;
+	}
+	uint64_t v = 0;
+	memcpy(&v, p, static_cast<size_t>(end - p));
+	h = (h ^ v) * 0xC4CEB53FE1A85EC3ULL;
+	h ^= h >> 29;
+	return h;
+}
+
+// -------------------------------------------------------
+// internal report every item that was not found
+// -------------------------------------------------------
+static void twk__report_missing() {
+	for (size_t i = 0; i < twk__num_items(); ++i) {
+		if (_twkCtx->items.found[i] == 0) {
+			const char* in = twk__get_string(_twkCtx->items.info[i].nameIndex);
+			twk__report_error("Item '%s' not found", in);
+		}
+	}
+}
+
+// -------------------------------------------------------
+// internal allocate snapshot slots
+// An item never spans two chunks. Returns -1 if the store
+// is full.
+// -------------------------------------------------------
+static int twk__snapshot_alloc(int count) {
+	TWKSnapshotStore& store = _twkCtx->snapshots;
+	if (count > TWK_SNAPSHOT_CHUNK_SIZE) {
+		return -1;
+	}
+	if (store.size % TWK_SNAPSHOT_CHUNK_SIZE + count > TWK_SNAPSHOT_CHUNK_SIZE) {
+		store.size += TWK_SNAPSHOT_CHUNK_SIZE - store.size % TWK_SNAPSHOT_CHUNK_SIZE;
+	}
+	int chunk = store.size / TWK_SNAPSHOT_CHUNK_SIZE;
+	if (chunk >= TWK_SNAPSHOT_MAX_CHUNKS) {
+		return -1;
+	}
+	if (store.chunks[chunk].load(std::memory_order_relaxed) == 0) {
+		std::atomic<uint32_t>* slots = twk__alloc_array<std::atomic<uint32_t> >(TWK_SNAPSHOT_CHUNK_SIZE);
+		for (int i = 0; i < TWK_SNAPSHOT_CHUNK_SIZE; ++i) {
+			new (slots + i) std::atomic<uint32_t>(0);
+		}
+		store.chunks[chunk].store(slots, std::memory_order_release);
+	}
+	int offset = store.size;
+	store.size += count;
+	return offset;
+}
+
+// -------------------------------------------------------
+// internal copy the value of an item into the store
+// -------------------------------------------------------
+static void twk__publish_item(int index) {
+	TWKSnapshotStore& store = _twkCtx->snapshots;
+	TWKItemInfo& info = _twkCtx->items.info[index];
+	int count = twk__value_count(index);
+	if (info.snapshotSlot == -1) {
+		info.snapshotSlot = twk__snapshot_alloc(count);
+		if (info.snapshotSlot == -1) {
+			return;
+		}
+	}
+	std::atomic<uint32_t>* slots = store.chunks[info.snapshotSlot / TWK_SNAPSHOT_CHUNK_SIZE].load(std::memory_order_relaxed) + info.snapshotSlot % TWK_SNAPSHOT_CHUNK_SIZE;
+	const float* ptr = _twkCtx->items.ptrs[index].fPtr;
+	for (int j = 0; j < count; ++j) {
+		uint32_t v;
+		memcpy(&v, ptr + j, sizeof(uint32_t));
+		slots[j].store(v, std::memory_order_relaxed);
+	}
+}
+
+// -------------------------------------------------------
+// internal publish snapshot
+// Copies the changed values and the values of new items or
+// with all set the values of every item into the store.
+// One sequence bump covers the whole reload so readers see
+// either the old or the new values of every item. Must be
+// called while holding the lock.
+// -------------------------------------------------------
+static void twk__publish_snapshot(bool all) {
+	TWKSnapshotStore& store = _twkCtx->snapshots;
+	if (!store.enabled) {
+		return;
+	}
+	uint32_t sequence = store.sequence.load(std::memory_order_relaxed);
+	store.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	if (all) {
+		store.items = 0;
+	}
+	else {
+		for (size_t i = 0; i < _twkCtx->changedItems.size(); ++i) {
+			int idx = _twkCtx->changedItems[i];
+			if (static_cast<size_t>(idx) < store.items) {
+				twk__publish_item(idx);
+			}
+		}
+	}
+	for (size_t i = store.items; i < twk__num_items(); ++i) {
+		twk__publish_item(static_cast<int>(i));
+	}
+	store.items = twk__num_items();
+	store.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// -------------------------------------------------------
+// internal collect notifications
+// Marks the changed items and their categories and queues
+// every matching callback once. Must be called while holding
+// the lock.
+// -------------------------------------------------------
+static void twk__collect_notifications(const int* changed, size_t count) {
+	if (_twkCtx->callbacks.empty() || count == 0) {
+		return;
+	}
+	int stamp = ++_twkCtx->notifyStamp;
+	for (size_t i = 0; i < count; ++i) {
+		int idx = changed[i];
+		_twkCtx->items.info[idx].notifyStamp = stamp;
+		_twkCtx->categories[_twkCtx->items.categories[idx]].notifyStamp = stamp;
+	}
+	for (size_t i = 0; i < _twkCtx->callbacks.size(); ++i) {
+		const TWKCallback& cb = _twkCtx->callbacks[i];
+		TWKNotification notification;
+		notification.callback = cb.callback;
+		notification.user = cb.user;
+		if (cb.category) {
+			int cid = twk__find_category(twk__get_string(cb.categoryNameIndex), _twkCtx->strings.lengths[cb.categoryNameIndex], cb.categoryHash);
+			if (cid != -1 && _twkCtx->categories[cid].notifyStamp == stamp) {
+				notification.categoryNameIndex = _twkCtx->categories[cid].nameIndex;
+				notification.nameIndex = -1;
+				_twkCtx->notifications.push_back(notification);
+			}
+		}
+		else {
+			int cid = twk__find_category(twk__get_string(cb.categoryNameIndex), _twkCtx->strings.lengths[cb.categoryNameIndex], cb.categoryHash);
+			int idx = twk__find_item(cid, twk__get_string(cb.nameIndex), _twkCtx->strings.lengths[cb.nameIndex], cb.nameHash);
+			if (idx != -1 && _twkCtx->items.info[idx].notifyStamp == stamp) {
+				notification.categoryNameIndex = _twkCtx->categories[_twkCtx->items.categories[idx]].nameIndex;
+				notification.nameIndex = _twkCtx->items.info[idx].nameIndex;
+				_twkCtx->notifications.push_back(notification);
+			}
+		}
+	}
+}
+
+// -------------------------------------------------------
+// internal dispatch notifications
+// Must be called without holding the lock. The queue is
+// copied so both vectors keep their capacity.
+// -------------------------------------------------------
+static void twk__dispatch_notifications() {
+	TWKVector<TWKNotification>& notifications = _twkCtx->dispatching;
+	{
+		std::lock_guard<std::mutex> guard(_twkCtx->lock);
+		if (_twkCtx->notifications.empty()) {
+			return;
+		}
+		notifications.assign(_twkCtx->notifications.begin(), _twkCtx->notifications.end());
+		_twkCtx->notifications.clear();
+	}
+	for (size_t i = 0; i < notifications.size(); ++i) {
+		const TWKNotification& n = notifications[i];
+		const char* name = n.nameIndex != -1 ? twk__get_string(n.nameIndex) : 0;
+		n.callback(twk__get_string(n.categoryNameIndex), name, n.user);
+	}
+	notifications.clear();
+}
+
+static void twk__parse_include(const char* path, int length, TWKStage* stage, const TWKIncludes* includes);
+
+// -------------------------------------------------------
+// internal parse expression
+// Compiles the expression that starts at p. Without a stage
+// it is stored in the context right away, a stage records it
+// as an entry so the order of the assignments is kept. An
+// invalid expression is stored without a program and the
+// error is reported when the stage is applied.
+// -------------------------------------------------------
+static const char* twk__parse_expression(const char* p, const char* end, TWKStage* stage, int categoryIndex, uint32_t categoryHash, const char* name, int length, uint32_t nameHash) {
+	bool valid = false;
+	if (stage == 0) {
+		if (categoryIndex == -1) {
+			const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+			return nl != 0 ? nl : end;
+		}
+		TWKDerivedStore& store = _twkCtx->derived;
+		store.compiledOps.clear();
+		store.compiledRefs.clear();
+		const char* next = twk__compile_expression(p, end, _twkCtx->categories[categoryIndex].hash, &store.compiledOps, &store.compiledRefs, &valid);
+		if (valid) {
+			twk__add_derived(categoryIndex, name, length, nameHash, twk__hash_block(p, next), store.compiledOps.data(), static_cast<int>(store.compiledOps.size()), store.compiledRefs.data(), static_cast<int>(store.compiledRefs.size()));
+		}
+		else {
+			twk__report_error("Invalid expression for '%.*s'", length, name);
+			twk__derived_override(twk__make_key(_twkCtx->categories[categoryIndex].hash, nameHash));
+		}
+		return next;
+	}
+	TWKStageDerived derived;
+	derived.firstOp = static_cast<int>(stage->ops.size());
+	derived.firstRef = static_cast<int>(stage->refs.size());
+	const char* next = twk__compile_expression(p, end, categoryHash, &stage->ops, &stage->refs, &valid);
+	if (categoryIndex == -1) {
+		stage->ops.resize(derived.firstOp);
+		stage->refs.resize(derived.firstRef);
+		return next;
+	}
+	derived.hash = twk__hash_block(p, next);
+	derived.numOps = static_cast<int>(stage->ops.size()) - derived.firstOp;
+	derived.numRefs = static_cast<int>(stage->refs.size()) - derived.firstRef;
+	derived.name = static_cast<int>(stage->names.size());
+	stage->names.insert(stage->names.end(), name, name + length);
+	stage->names.push_back('\0');
+	TWKStageEntry entry;
+	entry.categoryHash = categoryHash;
+	entry.nameHash = nameHash;
+	entry.category = categoryIndex;
+	entry.name = derived.name;
+	entry.offset = static_cast<int>(stage->derived.size());
+	entry.count = -1;
+	entry.item = -1;
+	stage->entries.push_back(entry);
+	stage->derived.push_back(derived);
+	return next;
+}
+
+// -------------------------------------------------------
+// internal parse text
+// Tokenizes and applies "name : v, v, v" in a single pass
+// without any temporary token storage. If a stage is passed
+// the values are only recorded and nothing else is touched
+// so this can run on any thread.
+// -------------------------------------------------------
+static uint32_t twk__parse_text(const char* text, const char* end, TWKStage* stage, const TWKIncludes* includes) {
+	float values[128];
+	int currentCategory = -1;
+	uint32_t currentCategoryHash = 0;
+	uint32_t tokens = 1;
+	TWKToken t;
+	TWKToken n;
+	const char* p = twk__next_token(text, text, end, &t);
+	while (t.type != TWKToken::EMPTY) {
+		if (t.type == TWKToken::INCLUDE) {
+			twk__parse_include(text + t.index, t.size, stage, includes);
+		}
+		if (t.type != TWKToken::NAME) {
+			p = twk__next_token(text, p, end, &t);
+			++tokens;
+			continue;
+		}
+		// names are used in place and hashed over their whole length
+		uint32_t nameHash = twk__fnv1a(text + t.index, t.size);
+		p = twk__next_token(text, p, end, &n);
+		++tokens;
+		if (n.type == TWKToken::OPEN_BRACES) {
+			if (stage != 0) {
+				currentCategoryHash = nameHash;
+				currentCategory = static_cast<int>(stage->categories.size());
+				stage->categories.push_back(static_cast<int>(stage->names.size()));
+				stage->names.insert(stage->names.end(), text + t.index, text + t.index + t.size);
+				stage->names.push_back('\0');
+			}
+			else {
+				uint32_t categoryHash = nameHash;
+				currentCategory = twk__find_category(text + t.index, t.size, categoryHash);
+				if (currentCategory == -1) {
+					currentCategory = twk__add_category(text + t.index, t.size, categoryHash);
+				}
+				// skip the block if it did not change since the last parse
+				TWKCategory& cat = _twkCtx->categories[currentCategory];
+				const char* blockEnd = twk__find_block_end(p, end);
+				uint64_t contentHash = twk__hash_block(p, blockEnd);
+				if (cat.seenGeneration != _twkCtx->generation) {
+					cat.seenGeneration = _twkCtx->generation;
+					// blocks with includes are always parsed since the included files might have changed
+					if (cat.hashValid && cat.contentHash == contentHash && memchr(p, '@', blockEnd - p) == 0) {
+						cat.skippedGeneration = _twkCtx->generation;
+						p = blockEnd;
 					}
-					fprintf(fp, "\n");
+					cat.contentHash = contentHash;
+					cat.hashValid = true;
+				}
+				else {
+					// more than one block - always parse the category
+					cat.hashValid = false;
+				}
+			}
+			p = twk__next_token(text, p, end, &t);
+			++tokens;
+		}
+		else if (n.type == TWKToken::ASSIGN) {
+			int count = 0;
+			const char* valueStart = p;
+			p = twk__next_token(text, p, end, &n);
+			++tokens;
+			while (n.type == TWKToken::NUMBER || n.type == TWKToken::DELIMITER) {
+				if (n.type == TWKToken::NUMBER && count < 128) {
+					values[count++] = n.value;
+				}
+				p = twk__next_token(text, p, end, &n);
+				++tokens;
+			}
+			// an operator or a name on the same line turns the values into an expression
+			if (n.type == TWKToken::OPERATOR || (n.type == TWKToken::NAME && memchr(valueStart, '\n', text + n.index - valueStart) == 0)) {
+				p = twk__parse_expression(valueStart, end, stage, currentCategory, currentCategoryHash, text + t.index, t.size, nameHash);
+				p = twk__next_token(text, p, end, &t);
+				++tokens;
+				continue;
+			}
+			if (stage == 0) {
+				twk__set_value(currentCategory, text + t.index, t.size, nameHash, values, count);
+			}
+			else if (currentCategory != -1) {
+				TWKStageEntry entry;
+				entry.categoryHash = currentCategoryHash;
+				entry.nameHash = nameHash;
+				entry.category = currentCategory;
+				entry.name = static_cast<int>(stage->names.size());
+				entry.offset = static_cast<int>(stage->values.size());
+				entry.count = count;
+				entry.item = -1;
+				stage->entries.push_back(entry);
+				stage->values.insert(stage->values.end(), values, values + count);
+				stage->names.insert(stage->names.end(), text + t.index, text + t.index + t.size);
+				stage->names.push_back('\0');
+			}
+			// the token that ended the value list starts the next statement
+			t = n;
+		}
+		else {
+			t = n;
+		}
+	}
+	// the final empty token is not counted
+	return tokens - 1;
+}
+
+// -------------------------------------------------------
+// internal statistics
+// -------------------------------------------------------
+static double twk__now() {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t twk__thread_id() {
+	return static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+static TWKReload* twk__reload(TWKStage* stage) {
+	return stage != 0 ? &stage->reload : &_twkCtx->reload;
+}
+
+static void twk__begin_reload(TWKReload* reload, double start) {
+	memset(&reload->stats, 0, sizeof(TwkReloadStats));
+	reload->loadStart = start;
+	reload->parseStart = start;
+	reload->thread = twk__thread_id();
+}
+
+static void twk__trace_event(const char* name, const char* fileName, double start, double duration, uint32_t thread, const TwkReloadStats& stats) {
+	TWKVector<TWKTraceEvent>& trace = _twkCtx->trace;
+	if (trace.empty()) {
+		return;
+	}
+	TWKTraceEvent& e = trace[_twkCtx->traceNext];
+	e.name = name;
+	// the file name is copied into the arena since the event outlives the call
+	e.fileName = fileName != 0 ? twk__get_string(twk__add_string(fileName, twk_fnv1a(fileName))) : 0;
+	e.start = start;
+	e.duration = duration;
+	e.thread = thread;
+	e.bytes = stats.bytesRead;
+	e.tokens = stats.tokens;
+	e.keys = stats.keysApplied;
+	if (++_twkCtx->traceNext == trace.size()) {
+		_twkCtx->traceNext = 0;
+		_twkCtx->traceWrapped = true;
+	}
+}
+
+static void twk__histogram_add(TwkHistogram* histogram, double value) {
+	int bucket = 0;
+	while (bucket < TWK_STATS_BUCKETS - 1 && value >= static_cast<double>(1u << bucket)) {
+		++bucket;
+	}
+	++histogram->buckets[bucket];
+	++histogram->count;
+	histogram->sum += value;
+	histogram->max = value > histogram->max ? value : histogram->max;
+}
+
+// -------------------------------------------------------
+// internal merge reload
+// Adds the counters of a stage that was loaded and parsed
+// on another thread and records its events. The phase times
+// are summed up so with several workers they can exceed the
+// total time.
+// -------------------------------------------------------
+static void twk__merge_reload(const TWKReload* staged, const char* fileName) {
+	TwkReloadStats& stats = _twkCtx->reload.stats;
+	const TwkReloadStats& other = staged->stats;
+	stats.bytesRead += other.bytesRead;
+	stats.tokens += other.tokens;
+	stats.keysApplied += other.keysApplied;
+	stats.lookupProbes += other.lookupProbes;
+	stats.lookupMisses += other.lookupMisses;
+	stats.loadTime += other.loadTime;
+	stats.parseTime += other.parseTime;
+	twk__trace_event("load", fileName, staged->loadStart, other.loadTime, staged->thread, other);
+	twk__trace_event("parse", fileName, staged->parseStart, other.parseTime, staged->thread, other);
+}
+
+// -------------------------------------------------------
+// internal finish reload
+// Records the reload of the context that started at start.
+// Must be called while holding the lock.
+// -------------------------------------------------------
+static void twk__finish_reload(const char* name, const char* fileName, double start, size_t allocations) {
+	TwkReloadStats& last = _twkCtx->reload.stats;
+	last.totalTime = twk__now() - start;
+	last.allocations = _twkAllocCounters.allocations.load() - allocations;
+	TwkStats& stats = _twkCtx->stats;
+	stats.last = last;
+	++stats.reloads;
+	twk__histogram_add(&stats.load, last.loadTime);
+	twk__histogram_add(&stats.parse, last.parseTime);
+	twk__histogram_add(&stats.apply, last.applyTime);
+	twk__histogram_add(&stats.total, last.totalTime);
+	twk__trace_event(name, fileName, start, last.totalTime, _twkCtx->reload.thread, last);
+}
+
+// -------------------------------------------------------
+// internal parse
+// Without a stage all values are applied and the found state,
+// snapshots and notifications are updated once for the text
+// and all of its includes.
+// -------------------------------------------------------
+static void twk__parse(const char* text, const char* end, TWKStage* stage, const TWKIncludes* includes) {
+	if (stage == 0) {
+		++_twkCtx->generation;
+		twk__clear_changed();
+	}
+	else {
+		stage->entries.clear();
+		stage->values.clear();
+		stage->derived.clear();
+		stage->ops.clear();
+		stage->refs.clear();
+		stage->categories.clear();
+		stage->includes.clear();
+		stage->failed.clear();
+		stage->names.clear();
+	}
+	TWKReload* reload = twk__reload(stage);
+	reload->parseStart = twk__now();
+	reload->stats.tokens += twk__parse_text(text, end, stage, includes);
+	double applyStart = twk__now();
+	reload->stats.parseTime += applyStart - reload->parseStart;
+	if (stage == 0) {
+		twk__update_derived_found();
+		twk__evaluate_derived();
+		twk__update_found();
+		twk__report_missing();
+		twk__publish_snapshot(false);
+		twk__collect_notifications(_twkCtx->changedItems.data(), _twkCtx->changedItems.size());
+		reload->stats.applyTime += twk__now() - applyStart;
+		twk__trace_event("parse", 0, reload->parseStart, reload->stats.parseTime, reload->thread, reload->stats);
+		twk__trace_event("apply", 0, applyStart, reload->stats.applyTime, reload->thread, reload->stats);
+	}
+}
+
+// -------------------------------------------------------
+// internal include path
+// Relative paths are relative to the directory of the file
+// that contains the directive.
+// -------------------------------------------------------
+static bool twk__include_path(const char* parent, const char* path, int length, char* out, size_t size) {
+	size_t prefix = 0;
+	bool absolute = path[0] == '/' || path[0] == '\\' || (length > 1 && path[1] == ':');
+	if (parent != 0 && !absolute) {
+		for (const char* c = parent; *c != '\0'; ++c) {
+			if (*c == '/' || *c == '\\') {
+				prefix = static_cast<size_t>(c - parent) + 1;
+			}
+		}
+	}
+	if (prefix + length + 1 > size) {
+		return false;
+	}
+	memcpy(out, parent, prefix);
+	memcpy(out + prefix, path, length);
+	out[prefix + length] = '\0';
+	return true;
+}
+
+static void twk__stage_name(TWKStage* stage, TWKVector<int>* list, const char* name) {
+	list->push_back(static_cast<int>(stage->names.size()));
+	stage->names.insert(stage->names.end(), name, name + strlen(name) + 1);
+}
+
+// -------------------------------------------------------
+// internal add source
+// Returns the existing source if the file is already watched.
+// -------------------------------------------------------
+static TWKSource* twk__add_source(const char* fileName, bool root) {
+	for (size_t i = 0; i < _twkCtx->sources.size(); ++i) {
+		TWKSource* source = _twkCtx->sources[i];
+		if (strcmp(source->fileName, fileName) == 0) {
+			source->root = source->root || root;
+			return source;
+		}
+	}
+	TWKSource* source = twk__new<TWKSource>();
+	source->fileName = twk__get_string(twk__add_string(fileName, twk_fnv1a(fileName)));
+	source->root = root;
+	source->loaded = false;
+	twk__watch_start(&source->watch, source->fileName);
+	twk__watch_reset(&source->watch, source->fileName);
+	_twkCtx->sources.push_back(source);
+	return source;
+}
+
+// -------------------------------------------------------
+// internal check if any watched source has changed
+// -------------------------------------------------------
+static bool twk__sources_changed() {
+	for (size_t i = 0; i < _twkCtx->sources.size(); ++i) {
+		TWKSource* source = _twkCtx->sources[i];
+		if (twk__watch_changed(&source->watch, source->fileName)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void twk__reset_sources() {
+	for (size_t i = 0; i < _twkCtx->sources.size(); ++i) {
+		TWKSource* source = _twkCtx->sources[i];
+		twk__watch_reset(&source->watch, source->fileName);
+	}
+}
+
+// -------------------------------------------------------
+// internal parse include
+// Loads the file and parses it in place of the directive.
+// A stage only records the paths, without a stage the file
+// is watched and errors are reported right away.
+// -------------------------------------------------------
+static void twk__parse_include(const char* path, int length, TWKStage* stage, const TWKIncludes* includes) {
+	char fileName[1024];
+	if (!twk__include_path(includes != 0 ? includes->fileName : 0, path, length, fileName, sizeof(fileName))) {
+		return;
+	}
+	bool loaded = false;
+	if (includes != 0 && includes->depth < TWK_MAX_INCLUDE_DEPTH) {
+		TWKFileData file;
+		if (twk__load_file(fileName, &includes->buffers[includes->depth], &file)) {
+			twk__reload(stage)->stats.bytesRead += file.size;
+			TWKIncludes nested = { fileName, includes->buffers, includes->depth + 1 };
+			twk__parse_text(file.data, file.data + file.size, stage, &nested);
+			twk__release_file(&file);
+			loaded = true;
+		}
+	}
+	if (stage != 0) {
+		twk__stage_name(stage, loaded ? &stage->includes : &stage->failed, fileName);
+	}
+	else {
+		if (_twkCtx->reloadable || _twkCtx->numRoots > 0) {
+			twk__add_source(fileName, false);
+		}
+		if (!loaded) {
+			twk__report_error("Cannot load include: '%s'", fileName);
+		}
+	}
+}
+
+// -------------------------------------------------------
+// internal resolve stage
+// Maps the entries to the registered items and converts the
+// values in place. Must be called while holding the lock.
+// -------------------------------------------------------
+static void twk__resolve_stage(TWKStage* stage) {
+	stage->resolvedItems = twk__num_items();
+	int next = 0;
+	int category = -1;
+	int categoryIndex = -1;
+	for (size_t i = 0; i < stage->entries.size(); ++i) {
+		TWKStageEntry& entry = stage->entries[i];
+		if (entry.count < 0) {
+			// derived values are resolved when they are evaluated
+			continue;
+		}
+		// the entries of a block share the category
+		if (entry.category != category) {
+			category = entry.category;
+			categoryIndex = twk__find_category(stage->names.data() + stage->categories[category]);
+		}
+		const char* name = stage->names.data() + entry.name;
+		entry.item = twk__find_next_item(categoryIndex, name, strlen(name), entry.nameHash, &next, &stage->reload.stats.lookupProbes);
+		if (entry.item != -1) {
+			float* values = stage->values.data() + entry.offset;
+			entry.count = twk__convert_value(entry.item, values, entry.count, values);
+		}
+		else {
+			++stage->reload.stats.lookupMisses;
+		}
+	}
+}
+
+// -------------------------------------------------------
+// internal apply stages
+// Copies the resolved values into the registered pointers.
+// The stages are applied in order so a later stage overrides
+// the values of an earlier one. Must be called while holding
+// the lock.
+// -------------------------------------------------------
+static void twk__apply_stages(TWKStage* const* stages, int count) {
+	for (int s = 0; s < count; ++s) {
+		const TWKStage* stage = stages[s];
+		for (size_t i = 0; i < stage->categories.size(); ++i) {
+			const char* category = stage->names.data() + stage->categories[i];
+			if (twk__find_category(category) == -1) {
+				twk__add_category(category, twk_fnv1a(category));
+			}
+		}
+	}
+	twk__reset_found();
+	twk__invalidate_categories();
+	twk__clear_changed();
+	for (int s = 0; s < count; ++s) {
+		const TWKStage* stage = stages[s];
+		int category = -1;
+		int categoryIndex = -1;
+		for (size_t i = 0; i < stage->entries.size(); ++i) {
+			const TWKStageEntry& entry = stage->entries[i];
+			uint64_t key = twk__make_key(entry.categoryHash, entry.nameHash);
+			// the entries of a block share the category
+			if (entry.category != category) {
+				category = entry.category;
+				categoryIndex = twk__find_category(stage->names.data() + stage->categories[category]);
+			}
+			if (entry.count < 0) {
+				const TWKStageDerived& derived = stage->derived[entry.offset];
+				const char* name = stage->names.data() + derived.name;
+				if (derived.numOps > 0) {
+					twk__add_derived(categoryIndex, name, strlen(name), entry.nameHash, derived.hash, stage->ops.data() + derived.firstOp, derived.numOps, stage->refs.data() + derived.firstRef, derived.numRefs);
+				}
+				else {
+					twk__report_error("Invalid expression for '%s'", name);
+					twk__derived_override(key);
+				}
+				continue;
+			}
+			twk__derived_override(key);
+			if (entry.item == -1) {
+				twk__pool_set(categoryIndex, key, stage->values.data() + entry.offset, entry.count);
+			}
+			else if (entry.count > 0) {
+				twk__write_value(entry.item, stage->values.data() + entry.offset, entry.count);
+				++_twkCtx->reload.stats.keysApplied;
+			}
+		}
+		for (size_t i = 0; i < stage->includes.size(); ++i) {
+			twk__add_source(stage->names.data() + stage->includes[i], false);
+		}
+		for (size_t i = 0; i < stage->failed.size(); ++i) {
+			const char* fileName = stage->names.data() + stage->failed[i];
+			twk__add_source(fileName, false);
+			twk__report_error("Cannot load include: '%s'", fileName);
+		}
+	}
+	twk__evaluate_derived();
+	twk__report_missing();
+	twk__publish_snapshot(false);
+	twk__collect_notifications(_twkCtx->changedItems.data(), _twkCtx->changedItems.size());
+}
+
+// -------------------------------------------------------
+// parse
+// -------------------------------------------------------
+void twk_parse(TWKContext* ctx, const char* text) {
+	TWKScope scope(ctx);
+	{
+		std::lock_guard<std::mutex> guard(_twkCtx->lock);
+		double start = twk__now();
+		size_t allocations = _twkAllocCounters.allocations.load();
+		size_t length = strlen(text);
+		twk__begin_reload(&_twkCtx->reload, start);
+		_twkCtx->reload.stats.bytesRead = length;
+		TWKIncludes includes = { 0, _twkCtx->includeBuffers, 0 };
+		twk__parse(text, text + length, 0, &includes);
+		twk__finish_reload("twk_parse", 0, start, allocations);
+	}
+	twk__dispatch_notifications();
+}
+
+// -------------------------------------------------------
+// background reload thread
+// Waits for a change, loads and parses the file into the
+// stage that is not pending and hands it over to the game
+// thread which applies it in twk_apply_pending.
+// -------------------------------------------------------
+#ifndef TWK_RELOAD_POLL_MS
+#define TWK_RELOAD_POLL_MS 50
+#endif
+
+static void twk__reload_thread(TWKContext* ctx) {
+	TWKScope scope(ctx);
+	std::unique_lock<std::mutex> guard(ctx->lock);
+	while (!ctx->stopReload) {
+		// the included files are only added while holding the lock
+		bool load = !ctx->loaded || twk__sources_changed();
+		guard.unlock();
+		load = load || twk__watch_changed(&ctx->watch, ctx->fileName);
+		guard.lock();
+		if (load && !ctx->stopReload) {
+			ctx->loaded = true;
+			int current = ctx->pendingStage == 0 ? 1 : 0;
+			TWKStage* stage = &ctx->stages[current];
+			twk__reset_sources();
+			guard.unlock();
+			twk__watch_reset(&ctx->watch, ctx->fileName);
+			twk__begin_reload(&stage->reload, twk__now());
+			TWKFileData file;
+			bool success = twk__load_file(ctx->fileName, &ctx->fileBuffer, &file);
+			if (success) {
+				stage->reload.stats.loadTime = twk__now() - stage->reload.loadStart;
+				stage->reload.stats.bytesRead = file.size;
+				TWKIncludes includes = { ctx->fileName, stage->buffers, 0 };
+				twk__parse(file.data, file.data + file.size, stage, &includes);
+				twk__release_file(&file);
+			}
+			guard.lock();
+			if (success) {
+				twk__resolve_stage(stage);
+				ctx->pendingStage = current;
+			}
+			else {
+				ctx->loadFailed = true;
+			}
+		}
+		ctx->reloadSignal.wait_for(guard, std::chrono::milliseconds(TWK_RELOAD_POLL_MS));
+	}
+}
+
+// -------------------------------------------------------
+// start background reload
+// -------------------------------------------------------
+void twk_start_background_reload(TWKContext* ctx) {
+	TWKScope scope(ctx);
+	if (_twkCtx->reloadable && _twkCtx->reloadThread == 0) {
+		_twkCtx->stopReload = false;
+		_twkCtx->reloadThread = twk__new<std::thread>(twk__reload_thread, _twkCtx);
+	}
+}
+
+// -------------------------------------------------------
+// apply pending values
+// -------------------------------------------------------
+bool twk_apply_pending(TWKContext* ctx) {
+	TWKScope scope(ctx);
+	{
+		std::lock_guard<std::mutex> guard(_twkCtx->lock);
+		if (_twkCtx->loadFailed) {
+			_twkCtx->loadFailed = false;
+			twk__report_error("Cannot load file: '%s'", _twkCtx->fileName);
+		}
+		if (_twkCtx->pendingStage == -1) {
+			return false;
+		}
+		double start = twk__now();
+		size_t allocations = _twkAllocCounters.allocations.load();
+		TWKStage* stage = &_twkCtx->stages[_twkCtx->pendingStage];
+		twk__begin_reload(&_twkCtx->reload, start);
+		twk__merge_reload(&stage->reload, _twkCtx->fileName);
+		twk__apply_stages(&stage, 1);
+		_twkCtx->reload.stats.applyTime = twk__now() - start;
+		twk__trace_event("apply", _twkCtx->fileName, start, _twkCtx->reload.stats.applyTime, _twkCtx->reload.thread, _twkCtx->reload.stats);
+		twk__finish_reload("twk_apply_pending", _twkCtx->fileName, start, allocations);
+		_twkCtx->pendingStage = -1;
+	}
+	twk__dispatch_notifications();
+	return true;
+}
+
+// -------------------------------------------------------
+// enable snapshots
+// -------------------------------------------------------
+void twk_enable_snapshots(TWKContext* ctx) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	_twkCtx->snapshots.enabled = true;
+	twk__publish_snapshot(true);
+}
+
+// -------------------------------------------------------
+// publish snapshot after changing values in code
+// -------------------------------------------------------
+void twk_snapshot_publish(TWKContext* ctx) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	twk__publish_snapshot(true);
+}
+
+// -------------------------------------------------------
+// get the snapshot reference of an item
+// Call this once during setup and keep the reference. The
+// offset is -1 if the item is unknown or the store is full.
+// -------------------------------------------------------
+TwkSnapshotRef twk_snapshot_ref(TWKContext* ctx, const char* category, const char* name) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	TwkSnapshotRef ref = { -1, 0 };
+	int idx = twk__find(twk__find_category(category), name);
+	if (idx != -1 && _twkCtx->snapshots.enabled) {
+		if (_twkCtx->items.info[idx].snapshotSlot == -1) {
+			// publishes the new items
+			twk__clear_changed();
+			twk__publish_snapshot(false);
+		}
+		int slot = _twkCtx->items.info[idx].snapshotSlot;
+		if (slot != -1) {
+			ref.offset = slot;
+			ref.count = twk__value_count(idx);
+		}
+	}
+	return ref;
+}
+
+// -------------------------------------------------------
+// seqlock read side
+// uint32_t seq;
+// do {
+//     seq = twk_snapshot_begin();
+//     twk_snapshot_load(a, &va);
+//     twk_snapshot_load(b, &vb);
+// } while (twk_snapshot_retry(seq));
+// -------------------------------------------------------
+uint32_t twk_snapshot_begin(TWKContext* ctx) {
+	TWKScope scope(ctx);
+	uint32_t sequence = _twkCtx->snapshots.sequence.load(std::memory_order_acquire);
+	while ((sequence & 1) != 0) {
+		std::this_thread::yield();
+		sequence = _twkCtx->snapshots.sequence.load(std::memory_order_acquire);
+	}
+	return sequence;
+}
+
+void twk_snapshot_load(TWKContext* ctx, const TwkSnapshotRef& ref, void* dest) {
+	TWKScope scope(ctx);
+	const std::atomic<uint32_t>* slots = _twkCtx->snapshots.chunks[ref.offset / TWK_SNAPSHOT_CHUNK_SIZE].load(std::memory_order_acquire) + ref.offset % TWK_SNAPSHOT_CHUNK_SIZE;
+	uint32_t* out = static_cast<uint32_t*>(dest);
+	for (int i = 0; i < ref.count; ++i) {
+		out[i] = slots[i].load(std::memory_order_relaxed);
+	}
+}
+
+bool twk_snapshot_retry(TWKContext* ctx, uint32_t sequence) {
+	TWKScope scope(ctx);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return _twkCtx->snapshots.sequence.load(std::memory_order_relaxed) != sequence;
+}
+
+// -------------------------------------------------------
+// read a single item from the snapshot
+// -------------------------------------------------------
+bool twk_snapshot_read(TWKContext* ctx, const TwkSnapshotRef& ref, void* dest) {
+	TWKScope scope(ctx);
+	if (ref.offset == -1) {
+		return false;
+	}
+	uint32_t sequence;
+	do {
+		sequence = twk_snapshot_begin(ctx);
+		twk_snapshot_load(ctx, ref, dest);
+	} while (twk_snapshot_retry(ctx, sequence));
+	return true;
+}
+
+// -------------------------------------------------------
+// load many files
+// Every root file is read and parsed into its own stage by a
+// pool of worker threads. The stages are resolved and applied
+// in the order of the files once all workers are done so the
+// result does not depend on the scheduling. A reload only
+// parses the roots that changed on the calling thread and
+// applies the stages of the others again, so after the first
+// load no threads are started and nothing is allocated.
+// -------------------------------------------------------
+#ifndef TWK_MAX_LOAD_THREADS
+#define TWK_MAX_LOAD_THREADS 16
+#endif
+
+static void twk__load_worker(TWKContext* ctx, std::atomic<int>* next) {
+	TWKScope scope(ctx);
+	int count = static_cast<int>(ctx->rootQueue.size());
+	int i = next->fetch_add(1);
+	while (i < count) {
+		TWKSource* source = ctx->sources[ctx->rootQueue[i]];
+		TWKReload* reload = &source->stage.reload;
+		twk__begin_reload(reload, twk__now());
+		TWKFileData file;
+		source->loaded = twk__load_file(source->fileName, &source->buffer, &file);
+		if (source->loaded) {
+			reload->stats.loadTime = twk__now() - reload->loadStart;
+			reload->stats.bytesRead = file.size;
+			TWKIncludes includes = { source->fileName, source->stage.buffers, 0 };
+			twk__parse(file.data, file.data + file.size, &source->stage, &includes);
+			twk__release_file(&file);
+		}
+		i = next->fetch_add(1);
+	}
+}
+
+// -------------------------------------------------------
+// internal load roots
+// With parallel set every root is parsed by the pool of
+// workers. Otherwise only the roots that changed, that were
+// not loaded or whose stage was resolved before more items
+// were registered are parsed again. A changed include can
+// belong to any root and parses all of them.
+// -------------------------------------------------------
+static bool twk__load_roots(bool parallel) {
+	double start = twk__now();
+	size_t allocations = _twkAllocCounters.allocations.load();
+	int count = _twkCtx->numRoots;
+	TWKVector<int>& queue = _twkCtx->rootQueue;
+	TWKVector<TWKStage*>& stages = _twkCtx->rootStages;
+	queue.clear();
+	{
+		std::lock_guard<std::mutex> guard(_twkCtx->lock);
+		bool all = parallel;
+		for (size_t i = count; i < _twkCtx->sources.size() && !all; ++i) {
+			all = twk__watch_changed(&_twkCtx->sources[i]->watch, _twkCtx->sources[i]->fileName);
+		}
+		for (int i = 0; i < count; ++i) {
+			TWKSource* source = _twkCtx->sources[i];
+			if (all || !source->loaded || source->stage.resolvedItems != twk__num_items() || twk__watch_changed(&source->watch, source->fileName)) {
+				queue.push_back(i);
+			}
+		}
+		twk__reset_sources();
+	}
+	std::atomic<int> next(0);
+	int numThreads = parallel ? static_cast<int>(std::thread::hardware_concurrency()) : 1;
+	numThreads = numThreads < static_cast<int>(queue.size()) ? numThreads : static_cast<int>(queue.size());
+	numThreads = numThreads < TWK_MAX_LOAD_THREADS ? numThreads : TWK_MAX_LOAD_THREADS;
+	std::thread* threads[TWK_MAX_LOAD_THREADS];
+	// the calling thread is one of the workers
+	for (int i = 1; i < numThreads; ++i) {
+		threads[i] = twk__new<std::thread>(twk__load_worker, _twkCtx, &next);
+	}
+	twk__load_worker(_twkCtx, &next);
+	for (int i = 1; i < numThreads; ++i) {
+		threads[i]->join();
+		twk__delete(threads[i]);
+	}
+	stages.clear();
+	{
+		std::lock_guard<std::mutex> guard(_twkCtx->lock);
+		twk__begin_reload(&_twkCtx->reload, start);
+		for (size_t i = 0; i < queue.size(); ++i) {
+			TWKSource* source = _twkCtx->sources[queue[i]];
+			if (source->loaded) {
+				twk__resolve_stage(&source->stage);
+				twk__merge_reload(&source->stage.reload, source->fileName);
+			}
+			else {
+				twk__report_error("Cannot load file: '%s'", source->fileName);
+			}
+		}
+		for (int i = 0; i < count; ++i) {
+			if (_twkCtx->sources[i]->loaded) {
+				stages.push_back(&_twkCtx->sources[i]->stage);
+			}
+		}
+		if (!stages.empty()) {
+			double applyStart = twk__now();
+			twk__apply_stages(stages.data(), static_cast<int>(stages.size()));
+			_twkCtx->reload.stats.applyTime = twk__now() - applyStart;
+			twk__trace_event("apply", 0, applyStart, _twkCtx->reload.stats.applyTime, _twkCtx->reload.thread, _twkCtx->reload.stats);
+			twk__finish_reload("twk_load_many", 0, start, allocations);
+		}
+	}
+	twk__dispatch_notifications();
+	return !stages.empty();
+}
+
+bool twk_load_many(TWKContext* ctx, const char* const* files, int count) {
+	TWKScope scope(ctx);
+	if (_twkCtx->reloadable) {
+		twk__report_error("twk_load_many requires a context without a file");
+		return false;
+	}
+	if (count <= 0) {
+		return false;
+	}
+	{
+		// the roots are kept in order at the front of the sources
+		std::lock_guard<std::mutex> guard(_twkCtx->lock);
+		for (size_t i = 0; i < _twkCtx->sources.size(); ++i) {
+			_twkCtx->sources[i]->root = false;
+		}
+		int numRoots = 0;
+		for (int i = 0; i < count; ++i) {
+			TWKSource* source = twk__add_source(files[i], true);
+			source->loaded = false;
+			// a file that is listed twice is only loaded once
+			TWKVector<TWKSource*>::iterator it = std::find(_twkCtx->sources.begin() + numRoots, _twkCtx->sources.end(), source);
+			if (it != _twkCtx->sources.end()) {
+				std::rotate(_twkCtx->sources.begin() + numRoots, it, it + 1);
+				++numRoots;
+			}
+		}
+		_twkCtx->numRoots = numRoots;
+	}
+	return twk__load_roots(true);
+}
+
+// -------------------------------------------------------
+// load
+// -------------------------------------------------------
+bool twk_load(TWKContext* ctx) {
+	TWKScope scope(ctx);
+	if (_twkCtx->reloadThread != 0) {
+		return twk_apply_pending(ctx);
+	}
+	if (_twkCtx->numRoots > 0) {
+		return twk__sources_changed() && twk__load_roots(false);
+	}
+	if (_twkCtx->reloadable && (twk__requires_loading() || twk__sources_changed())) {
+		_twkCtx->loaded = true;
+		// changes while reading are picked up by the next call
+		twk__watch_reset(&_twkCtx->watch, _twkCtx->fileName);
+		twk__reset_sources();
+		double start = twk__now();
+		size_t allocations = _twkAllocCounters.allocations.load();
+		TWKFileData file;
+		if (twk__load_file(_twkCtx->fileName, &_twkCtx->fileBuffer, &file)) {
+			double loadTime = twk__now() - start;
+			{
+				std::lock_guard<std::mutex> guard(_twkCtx->lock);
+				TWKReload* reload = &_twkCtx->reload;
+				twk__begin_reload(reload, start);
+				reload->stats.loadTime = loadTime;
+				reload->stats.bytesRead = file.size;
+				twk__trace_event("load", _twkCtx->fileName, start, loadTime, reload->thread, reload->stats);
+				TWKIncludes includes = { _twkCtx->fileName, _twkCtx->includeBuffers, 0 };
+				twk__parse(file.data, file.data + file.size, 0, &includes);
+				twk__finish_reload("twk_load", _twkCtx->fileName, start, allocations);
+			}
+			twk__release_file(&file);
+			twk__dispatch_notifications();
+			return true;
+		}
+		twk__report_error("Cannot load file: '%s'", _twkCtx->fileName);
+		return false;
+	}
+	return false;
+}
+
+// -------------------------------------------------------
+// baked binary format
+// A settings file compiled offline so release builds do not
+// parse any text. All fields are written in the byte order
+// of the machine that baked the file, which is recorded in
+// the header, and a blob of the other byte order is
+// rejected. The entries hold 64 bit keys and are read in
+// place, so the blob must be 8 byte aligned:
+//
+// header
+// entries[count]   sorted by the slot of the perfect hash
+// seeds[buckets]   displacement per bucket
+// values[values]   the parsed values as floats
+// categories[n]    offset of every category name
+// names            zero terminated category names
+//
+// The perfect hash follows "hash, displace and compress":
+// keys are distributed into buckets and every bucket stores
+// the seed that moves all of its keys into free slots. A
+// negative seed stores the slot of a single key directly.
+// Looking up an item costs two hashes and one compare.
+// -------------------------------------------------------
+#define TWK_BINARY_MAGIC 0x424B5754
+#define TWK_BINARY_VERSION 2
+#define TWK_BINARY_BYTE_ORDER 0x01020304
+
+struct TWKBinaryHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t buckets;
+	uint32_t values;
+	uint32_t categories;
+	uint32_t namesSize;
+	uint32_t byteOrder;
+};
+
+struct TWKBinaryEntry {
+	uint64_t key;
+	uint32_t offset;
+	uint32_t count;
+};
+
+static inline uint32_t twk__mph_hash(uint64_t key, uint32_t seed) {
+	uint64_t h = key ^ (seed * 0x9E3779B97F4A7C15ULL);
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB53FE1A85EC3ULL;
+	h ^= h >> 33;
+	return static_cast<uint32_t>(h);
+}
+
+// -------------------------------------------------------
+// internal find slot of a key in the perfect hash
+// -------------------------------------------------------
+static int twk__mph_find(const TWKBinaryHeader* header, const TWKBinaryEntry* entries, const int32_t* seeds, uint64_t key) {
+	if (header->count == 0) {
+		return -1;
+	}
+	int32_t seed = seeds[twk__mph_hash(key, 0) % header->buckets];
+	uint32_t slot = 0;
+	if (seed < 0) {
+		// a corrupt blob can store any slot
+		if (seed == INT32_MIN) {
+			return -1;
+		}
+		slot = static_cast<uint32_t>(-seed - 1);
+		if (slot >= header->count) {
+			return -1;
+		}
+	}
+	else {
+		slot = twk__mph_hash(key, static_cast<uint32_t>(seed)) % header->count;
+	}
+	return entries[slot].key == key ? static_cast<int>(slot) : -1;
+}
+
+// -------------------------------------------------------
+// internal build perfect hash
+// Returns the seed of every bucket and the slot of every key.
+// -------------------------------------------------------
+static void twk__mph_build(const std::vector<uint64_t>& keys, uint32_t buckets, std::vector<int32_t>* seeds, std::vector<int>* slots) {
+	uint32_t n = static_cast<uint32_t>(keys.size());
+	std::vector<std::vector<int> > members(buckets);
+	for (uint32_t i = 0; i < n; ++i) {
+		members[twk__mph_hash(keys[i], 0) % buckets].push_back(static_cast<int>(i));
+	}
+	// largest buckets first while most of the slots are free
+	std::vector<int> order(buckets);
+	for (uint32_t i = 0; i < buckets; ++i) {
+		order[i] = static_cast<int>(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [&members](int a, int b) { return members[a].size() > members[b].size(); });
+	seeds->assign(buckets, 0);
+	slots->assign(n, -1);
+	std::vector<bool> used(n, false);
+	std::vector<uint32_t> candidate;
+	uint32_t nextFree = 0;
+	for (uint32_t i = 0; i < buckets; ++i) {
+		const std::vector<int>& bucket = members[order[i]];
+		if (bucket.empty()) {
+			break;
+		}
+		if (bucket.size() == 1) {
+			while (used[nextFree]) {
+				++nextFree;
+			}
+			used[nextFree] = true;
+			(*slots)[bucket[0]] = static_cast<int>(nextFree);
+			(*seeds)[order[i]] = -static_cast<int32_t>(nextFree) - 1;
+			continue;
+		}
+		for (uint32_t seed = 1; ; ++seed) {
+			candidate.clear();
+			for (size_t j = 0; j < bucket.size(); ++j) {
+				uint32_t slot = twk__mph_hash(keys[bucket[j]], seed) % n;
+				if (used[slot] || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
 					break;
 				}
+				candidate.push_back(slot);
+			}
+			if (candidate.size() == bucket.size()) {
+				for (size_t j = 0; j < bucket.size(); ++j) {
+					used[candidate[j]] = true;
+					(*slots)[bucket[j]] = static_cast<int>(candidate[j]);
+				}
+				(*seeds)[order[i]] = static_cast<int32_t>(seed);
+				break;
+			}
+		}
+	}
+}
+
+// -------------------------------------------------------
+// internal bake derived
+// A binary only holds constants so every derived value is
+// evaluated with the values of the text and its entry is
+// replaced by the result. The registered defaults are not
+// known offline, so a derived value whose inputs are not
+// all in the text or are on a cycle gets no values. The
+// values are evaluated in passes until no more of them can
+// be evaluated.
+// -------------------------------------------------------
+static void twk__bake_derived(TWKStage* stage) {
+	if (stage->derived.empty()) {
+		return;
+	}
+	std::vector<int> last;
+	TWKHashIndex index;
+	twk__index_init(&index);
+	for (size_t i = 0; i < stage->entries.size(); ++i) {
+		const TWKStageEntry& entry = stage->entries[i];
+		uint64_t key = twk__make_key(entry.categoryHash, entry.nameHash);
+		int idx = twk__index_find(&index, key);
+		if (idx == -1) {
+			twk__index_add(&index, key, static_cast<int>(last.size()));
+			last.push_back(static_cast<int>(i));
+		}
+		else {
+			last[idx] = static_cast<int>(i);
+		}
+	}
+	float inputs[TWK_EXPR_MAX_REFS];
+	float values[128];
+	bool progress = true;
+	while (progress) {
+		progress = false;
+		for (size_t i = 0; i < stage->entries.size(); ++i) {
+			TWKStageEntry& entry = stage->entries[i];
+			if (entry.count >= 0) {
+				continue;
+			}
+			const TWKStageDerived& derived = stage->derived[entry.offset];
+			bool ready = true;
+			bool missing = derived.numOps == 0 || last[twk__index_find(&index, twk__make_key(entry.categoryHash, entry.nameHash))] != static_cast<int>(i);
+			for (int r = 0; r < derived.numRefs && ready && !missing; ++r) {
+				int idx = twk__index_find(&index, stage->refs[derived.firstRef + r]);
+				const TWKStageEntry* input = idx != -1 ? &stage->entries[last[idx]] : 0;
+				if (input == 0 || input->count == 0 || input->count > 1) {
+					missing = true;
+				}
+				else if (input->count < 0) {
+					ready = false;
+				}
+				else {
+					inputs[r] = stage->values[input->offset];
+				}
+			}
+			if (missing) {
+				entry.offset = 0;
+				entry.count = 0;
+				progress = true;
+			}
+			else if (ready) {
+				int count = twk__eval_expression(stage->ops.data() + derived.firstOp, derived.numOps, inputs, values);
+				entry.offset = static_cast<int>(stage->values.size());
+				entry.count = count;
+				stage->values.insert(stage->values.end(), values, values + count);
+				progress = true;
+			}
+		}
+	}
+	// whatever is left is on a cycle
+	for (size_t i = 0; i < stage->entries.size(); ++i) {
+		if (stage->entries[i].count < 0) {
+			stage->entries[i].offset = 0;
+			stage->entries[i].count = 0;
+		}
+	}
+	twk__index_release(&index);
+}
+
+// -------------------------------------------------------
+// bake binary
+// Parses the text and returns the binary blob. The caller
+// has to delete[] the returned buffer. Does not require
+// twk_init so it can be used by offline tools.
+// -------------------------------------------------------
+char* twk_bake_binary(const char* text, size_t* size) {
+	TWKStage stage;
+	twk__begin_reload(&stage.reload, 0.0);
+	// includes are relative to the working directory
+	TWKIncludes includes = { 0, stage.buffers, 0 };
+	twk__parse(text, text + strlen(text), &stage, &includes);
+	twk__bake_derived(&stage);
+	// the last assignment of a key wins like in twk_parse
+	std::vector<uint64_t> keys;
+	std::vector<int> source;
+	TWKHashIndex index;
+	twk__index_init(&index);
+	for (size_t i = 0; i < stage.entries.size(); ++i) {
+		const TWKStageEntry& entry = stage.entries[i];
+		uint64_t key = twk__make_key(entry.categoryHash, entry.nameHash);
+		int idx = twk__index_find(&index, key);
+		if (idx == -1) {
+			twk__index_add(&index, key, static_cast<int>(keys.size()));
+			keys.push_back(key);
+			source.push_back(static_cast<int>(i));
+		}
+		else {
+			source[idx] = static_cast<int>(i);
+		}
+	}
+	twk__index_release(&index);
+	TWKBinaryHeader header;
+	header.magic = TWK_BINARY_MAGIC;
+	header.version = TWK_BINARY_VERSION;
+	header.count = static_cast<uint32_t>(keys.size());
+	header.buckets = header.count / 4 + 1;
+	header.values = static_cast<uint32_t>(stage.values.size());
+	header.categories = static_cast<uint32_t>(stage.categories.size());
+	header.namesSize = static_cast<uint32_t>(stage.names.size());
+	header.byteOrder = TWK_BINARY_BYTE_ORDER;
+	std::vector<int32_t> seeds;
+	std::vector<int> slots;
+	twk__mph_build(keys, header.buckets, &seeds, &slots);
+	std::vector<TWKBinaryEntry> entries(header.count);
+	for (uint32_t i = 0; i < header.count; ++i) {
+		const TWKStageEntry& entry = stage.entries[source[i]];
+		TWKBinaryEntry& e = entries[slots[i]];
+		e.key = keys[i];
+		e.offset = static_cast<uint32_t>(entry.offset);
+		e.count = static_cast<uint32_t>(entry.count);
+	}
+	size_t total = sizeof(TWKBinaryHeader) + header.count * sizeof(TWKBinaryEntry) + header.buckets * sizeof(int32_t)
+		+ header.values * sizeof(float) + header.categories * sizeof(uint32_t) + header.namesSize;
+	char* data = new char[total];
+	char* p = data;
+	memcpy(p, &header, sizeof(TWKBinaryHeader));
+	p += sizeof(TWKBinaryHeader);
+	memcpy(p, entries.data(), header.count * sizeof(TWKBinaryEntry));
+	p += header.count * sizeof(TWKBinaryEntry);
+	memcpy(p, seeds.data(), header.buckets * sizeof(int32_t));
+	p += header.buckets * sizeof(int32_t);
+	memcpy(p, stage.values.data(), header.values * sizeof(float));
+	p += header.values * sizeof(float);
+	for (uint32_t i = 0; i < header.categories; ++i) {
+		uint32_t offset = static_cast<uint32_t>(stage.categories[i]);
+		memcpy(p, &offset, sizeof(uint32_t));
+		p += sizeof(uint32_t);
+	}
+	memcpy(p, stage.names.data(), header.namesSize);
+	*size = total;
+	return data;
+}
+
+// -------------------------------------------------------
+// internal load binary
+// Binds every registered item with one lookup in the perfect
+// hash. The blob only holds the hashes of the keys so unlike
+// the text parser it can not tell colliding names apart.
+// Must be called while holding the lock.
+// -------------------------------------------------------
+static bool twk__load_binary(const void* data, size_t size) {
+	const char* p = static_cast<const char*>(data);
+	TWKBinaryHeader header;
+	if (size < sizeof(TWKBinaryHeader)) {
+		twk__report_error("Invalid binary settings");
+		return false;
+	}
+	if (reinterpret_cast<uintptr_t>(data) % 8 != 0) {
+		twk__report_error("Binary settings must be 8 byte aligned");
+		return false;
+	}
+	memcpy(&header, p, sizeof(TWKBinaryHeader));
+	if (header.byteOrder == 0x04030201) {
+		twk__report_error("Binary settings were baked with a different byte order");
+		return false;
+	}
+	uint64_t total = sizeof(TWKBinaryHeader) + static_cast<uint64_t>(header.count) * sizeof(TWKBinaryEntry) + static_cast<uint64_t>(header.buckets) * sizeof(int32_t)
+		+ static_cast<uint64_t>(header.values) * sizeof(float) + static_cast<uint64_t>(header.categories) * sizeof(uint32_t) + header.namesSize;
+	if (header.magic != TWK_BINARY_MAGIC || header.version != TWK_BINARY_VERSION || header.byteOrder != TWK_BINARY_BYTE_ORDER || header.buckets == 0 || total > size) {
+		twk__report_error("Invalid binary settings");
+		return false;
+	}
+	const TWKBinaryEntry* entries = reinterpret_cast<const TWKBinaryEntry*>(p + sizeof(TWKBinaryHeader));
+	const int32_t* seeds = reinterpret_cast<const int32_t*>(entries + header.count);
+	const float* values = reinterpret_cast<const float*>(seeds + header.buckets);
+	const uint32_t* categories = reinterpret_cast<const uint32_t*>(values + header.values);
+	const char* names = reinterpret_cast<const char*>(categories + header.categories);
+	for (uint32_t i = 0; i < header.categories; ++i) {
+		if (categories[i] < header.namesSize && memchr(names + categories[i], '\0', header.namesSize - categories[i]) != 0) {
+			const char* category = names + categories[i];
+			if (twk__find_category(category) == -1) {
+				twk__add_category(category, twk_fnv1a(category));
+			}
+		}
+	}
+	twk__invalidate_categories();
+	twk__reset_found();
+	twk__clear_changed();
+	float converted[128];
+	for (size_t i = 0; i < twk__num_items(); ++i) {
+		uint64_t key = twk__make_key(_twkCtx->categories[_twkCtx->items.categories[i]].hash, _twkCtx->items.hashes[i]);
+		int slot = twk__mph_find(&header, entries, seeds, key);
+		++_twkCtx->reload.stats.lookupProbes;
+		if (slot != -1) {
+			const TWKBinaryEntry& entry = entries[slot];
+			if (entry.count <= 128 && static_cast<uint64_t>(entry.offset) + entry.count <= header.values) {
+				int count = twk__convert_value(static_cast<int>(i), values + entry.offset, static_cast<int>(entry.count), converted);
+				if (count > 0) {
+					twk__write_value(static_cast<int>(i), converted, count);
+					++_twkCtx->reload.stats.keysApplied;
+				}
+			}
+		}
+		else {
+			++_twkCtx->reload.stats.lookupMisses;
+		}
+	}
+	// every key without an item goes to the pool
+	for (uint32_t i = 0; i < header.count; ++i) {
+		const TWKBinaryEntry& entry = entries[i];
+		if (static_cast<uint64_t>(entry.offset) + entry.count <= header.values && twk__find_item(entry.key) == -1) {
+			int categoryIndex = twk__index_find(&_twkCtx->categoryIndex, static_cast<uint32_t>(entry.key >> 32));
+			if (categoryIndex != -1) {
+				twk__pool_set(categoryIndex, entry.key, values + entry.offset, static_cast<int>(entry.count));
+			}
+		}
+	}
+	twk__report_missing();
+	twk__publish_snapshot(false);
+	twk__collect_notifications(_twkCtx->changedItems.data(), _twkCtx->changedItems.size());
+	return true;
+}
+
+// -------------------------------------------------------
+// load binary
+// The blob is only borrowed during the call.
+// -------------------------------------------------------
+bool twk_load_binary(TWKContext* ctx, const void* data, size_t size) {
+	TWKScope scope(ctx);
+	bool ret = false;
+	{
+		std::lock_guard<std::mutex> guard(_twkCtx->lock);
+		double start = twk__now();
+		size_t allocations = _twkAllocCounters.allocations.load();
+		twk__begin_reload(&_twkCtx->reload, start);
+		_twkCtx->reload.stats.bytesRead = size;
+		ret = twk__load_binary(data, size);
+		if (ret) {
+			_twkCtx->reload.stats.applyTime = twk__now() - start;
+			twk__trace_event("apply", 0, start, _twkCtx->reload.stats.applyTime, _twkCtx->reload.thread, _twkCtx->reload.stats);
+			twk__finish_reload("twk_load_binary", 0, start, allocations);
+		}
+	}
+	twk__dispatch_notifications();
+	return ret;
+}
+
+bool twk_load_binary(TWKContext* ctx, const char* fileName) {
+	TWKScope scope(ctx);
+	bool ret = false;
+	{
+		// the read buffer is kept for the next reload
+		std::lock_guard<std::mutex> guard(_twkCtx->lock);
+		double start = twk__now();
+		size_t allocations = _twkAllocCounters.allocations.load();
+		TWKFileData file;
+		if (!twk__load_file(fileName, &_twkCtx->binaryBuffer, &file)) {
+			twk__report_error("Cannot load file: '%s'", fileName);
+			return false;
+		}
+		TWKReload* reload = &_twkCtx->reload;
+		twk__begin_reload(reload, start);
+		reload->stats.loadTime = twk__now() - start;
+		reload->stats.bytesRead = file.size;
+		twk__trace_event("load", fileName, start, reload->stats.loadTime, reload->thread, reload->stats);
+		double applyStart = twk__now();
+		ret = twk__load_binary(file.data, file.size);
+		twk__release_file(&file);
+		if (ret) {
+			reload->stats.applyTime = twk__now() - applyStart;
+			twk__trace_event("apply", fileName, applyStart, reload->stats.applyTime, reload->thread, reload->stats);
+			twk__finish_reload("twk_load_binary", fileName, start, allocations);
+		}
+	}
+	twk__dispatch_notifications();
+	return ret;
+}
+
+// -------------------------------------------------------
+// statistics
+// -------------------------------------------------------
+TwkStats twk_stats(TWKContext* ctx) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	return _twkCtx->stats;
+}
+
+// -------------------------------------------------------
+// enable trace
+// Keeps the last maxEvents events, 0 turns tracing off.
+// -------------------------------------------------------
+void twk_enable_trace(TWKContext* ctx, int maxEvents) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	_twkCtx->trace.assign(maxEvents > 0 ? static_cast<size_t>(maxEvents) : 0, TWKTraceEvent());
+	_twkCtx->trace.shrink_to_fit();
+	_twkCtx->traceNext = 0;
+	_twkCtx->traceWrapped = false;
+}
+
+// -------------------------------------------------------
+// internal append formatted text
+// -------------------------------------------------------
+static void twk__append_format(TWKVector<char>* buffer, const char* format, ...) {
+	char text[256];
+	va_list args;
+	va_start(args, format);
+#ifdef _WIN32
+	int l = vsnprintf_s(text, sizeof(text), _TRUNCATE, format, args);
+#else
+	int l = vsnprintf(text, sizeof(text), format, args);
+#endif
+	va_end(args);
+	if (l > 0) {
+		l = l < static_cast<int>(sizeof(text)) ? l : static_cast<int>(sizeof(text)) - 1;
+		buffer->insert(buffer->end(), text, text + l);
+	}
+}
+
+static void twk__append_json_string(TWKVector<char>* buffer, const char* text) {
+	buffer->push_back('"');
+	for (const char* c = text; *c != '\0'; ++c) {
+		if (*c == '"' || *c == '\\') {
+			buffer->push_back('\\');
+		}
+		if (static_cast<unsigned char>(*c) >= 0x20) {
+			buffer->push_back(*c);
+		}
+	}
+	buffer->push_back('"');
+}
+
+// -------------------------------------------------------
+// write trace
+// Writes the recorded events as complete events in the
+// Chrome trace event format which can be opened in
+// chrome://tracing or Perfetto. The timestamps are taken
+// from std::chrono::steady_clock.
+// -------------------------------------------------------
+bool twk_write_trace(TWKContext* ctx, const char* fileName) {
+	TWKScope scope(ctx);
+#ifdef _WIN32
+	unsigned long pid = GetCurrentProcessId();
+#else
+	unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+	TWKVector<char> buffer;
+	{
+		std::lock_guard<std::mutex> guard(_twkCtx->lock);
+		const TWKVector<TWKTraceEvent>& trace = _twkCtx->trace;
+		size_t first = _twkCtx->traceWrapped ? _twkCtx->traceNext : 0;
+		size_t count = _twkCtx->traceWrapped ? trace.size() : _twkCtx->traceNext;
+		buffer.reserve(64 + count * 192);
+		twk__append_format(&buffer, "{\"traceEvents\":[");
+		for (size_t i = 0; i < count; ++i) {
+			const TWKTraceEvent& e = trace[(first + i) % trace.size()];
+			twk__append_format(&buffer, "%s\n{\"name\":\"%s\",\"cat\":\"tweakable\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%u,",
+				i != 0 ? "," : "", e.name, e.start, e.duration, pid, e.thread);
+			twk__append_format(&buffer, "\"args\":{\"bytes\":%llu,\"tokens\":%u,\"keys\":%u", static_cast<unsigned long long>(e.bytes), e.tokens, e.keys);
+			if (e.fileName != 0) {
+				twk__append_format(&buffer, ",\"file\":");
+				twk__append_json_string(&buffer, e.fileName);
 			}
+			twk__append_format(&buffer, "}}");
 		}
-		fprintf(fp, "}\n");
-		fclose(fp);
+		twk__append_format(&buffer, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	}
+	if (!twk__write_file_atomic(fileName, buffer.data(), buffer.size())) {
+		twk__report_error("Cannot write file: '%s'", fileName);
+		return false;
+	}
+	return true;
+}
+
+// -------------------------------------------------------
+// verify that all items were found
+// -------------------------------------------------------
+bool twk_verify(TWKContext* ctx) {
+	TWKScope scope(ctx);
+	const TWKVector<uint8_t>& found = _twkCtx->items.found;
+	for (size_t i = 0; i < found.size(); ++i) {
+		if (found[i] == 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// -------------------------------------------------------
+// number of categories
+// -------------------------------------------------------
+int twk_num_categories(TWKContext* ctx) {
+	TWKScope scope(ctx);
+	return _twkCtx->categories.size();
+}
+
+// -------------------------------------------------------
+// category name 
+// -------------------------------------------------------
+const char* twk_get_category_name(TWKContext* ctx, int index) {
+	TWKScope scope(ctx);
+	return twk__get_string(_twkCtx->categories[index].nameIndex);
+}
+
+// -------------------------------------------------------
+// all tweakbales for one category
+// -------------------------------------------------------
+int twk_get_tweakables(TWKContext* ctx, int categoryIndex, Tweakable* ret, int max) {
+	TWKScope scope(ctx);
+	int cnt = 0;
+	const TWKItemStore& items = _twkCtx->items;
+	for (size_t i = 0; i < items.categories.size(); ++i) {
+		if (items.categories[i] == static_cast<uint32_t>(categoryIndex) && cnt < max) {
+			Tweakable& t = ret[cnt++];
+			const TWKValuePtr& ptr = items.ptrs[i];
+			t.type = static_cast<TweakableType>(items.types[i]);
+			switch (t.type) {
+				case ST_FLOAT: t.ptr.fPtr = ptr.fPtr; break;
+				case ST_INT: t.ptr.iPtr = ptr.iPtr; break;
+				case ST_UINT: t.ptr.uiPtr = ptr.uiPtr; break;
+				case ST_VEC2: t.ptr.v2Ptr = ptr.v2Ptr; break;
+				case ST_VEC3: t.ptr.v3Ptr = ptr.v3Ptr; break;
+				case ST_VEC4: t.ptr.v4Ptr = ptr.v4Ptr; break;
+				case ST_COLOR: t.ptr.cPtr = ptr.cPtr; break;
+				case ST_ARRAY: t.ptr.arPtr = ptr.arPtr; break;
+				case ST_CURVE: t.ptr.curvePtr = ptr.curvePtr; break;
+				case ST_NONE: break;
+			}
+			t.arrayLength = items.info[i].arrayLength;
+			t.name = twk__get_string(items.info[i].nameIndex);
+		}
+	}
+	return cnt;
+}
+
+// -------------------------------------------------------
+// all tweakbales for one category
+// -------------------------------------------------------
+int twk_get_tweakables(TWKContext* ctx, const char* category, Tweakable* ret, int max) {
+	TWKScope scope(ctx);
+	int cid = twk__find_category(category);
+	return cid != -1 ? twk_get_tweakables(ctx, cid, ret, max) : 0;
+}
+
+// -------------------------------------------------------
+// categories with changed values in the last load or set
+// by handle since then
+// -------------------------------------------------------
+int twk_get_changed_categories(TWKContext* ctx, int* ret, int max) {
+	TWKScope scope(ctx);
+	int cnt = 0;
+	for (size_t i = 0; i < _twkCtx->changedItems.size(); ++i) {
+		int cid = static_cast<int>(_twkCtx->items.categories[_twkCtx->changedItems[i]]);
+		bool known = false;
+		for (int j = 0; j < cnt; ++j) {
+			known = known || ret[j] == cid;
+		}
+		if (!known && cnt < max) {
+			ret[cnt++] = cid;
+		}
+	}
+	return cnt;
+}
+
+// -------------------------------------------------------
+// tweakables with changed values in the last load or set
+// by handle since then
+// -------------------------------------------------------
+int twk_get_changed_tweakables(TWKContext* ctx, Tweakable* ret, int max) {
+	TWKScope scope(ctx);
+	int cnt = 0;
+	for (size_t i = 0; i < _twkCtx->changedItems.size() && cnt < max; ++i) {
+		int idx = _twkCtx->changedItems[i];
+		Tweakable& t = ret[cnt++];
+		t.type = static_cast<TweakableType>(_twkCtx->items.types[idx]);
+		t.ptr.fPtr = _twkCtx->items.ptrs[idx].fPtr;
+		t.arrayLength = _twkCtx->items.info[idx].arrayLength;
+		t.name = twk__get_string(_twkCtx->items.info[idx].nameIndex);
+	}
+	return cnt;
+}
+
+// -------------------------------------------------------
+// register change callback for one item
+// -------------------------------------------------------
+void twk_on_change(TWKContext* ctx, const char* category, const char* name, twkChangeCallback callback, void* user) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	TWKCallback cb;
+	cb.categoryHash = twk_fnv1a(category);
+	cb.nameHash = twk_fnv1a(name);
+	cb.categoryNameIndex = twk__add_string(category, cb.categoryHash);
+	cb.nameIndex = twk__add_string(name, cb.nameHash);
+	cb.category = false;
+	cb.callback = callback;
+	cb.user = user;
+	_twkCtx->callbacks.push_back(cb);
+}
+
+// -------------------------------------------------------
+// register change callback for a category
+// -------------------------------------------------------
+void twk_on_change(TWKContext* ctx, const char* category, twkChangeCallback callback, void* user) {
+	TWKScope scope(ctx);
+	std::lock_guard<std::mutex> guard(_twkCtx->lock);
+	TWKCallback cb;
+	cb.categoryHash = twk_fnv1a(category);
+	cb.nameHash = 0;
+	cb.categoryNameIndex = twk__add_string(category, cb.categoryHash);
+	cb.nameIndex = -1;
+	cb.category = true;
+	cb.callback = callback;
+	cb.user = user;
+	_twkCtx->callbacks.push_back(cb);
+}
+
+// -------------------------------------------------------
+// internal set item
+// Writes the value through the registered pointer. A new
+// value is recorded as changed, published to the snapshot
+// store and the callbacks of the item and its category are
+// called once the lock is released. The category block is
+// applied again by the next parse.
+// -------------------------------------------------------
+static void twk__set_item(int index, const void* value, int count) {
+	bool notify = false;
+	{
+		std::lock_guard<std::mutex> guard(_twkCtx->lock);
+		if (index < 0 || static_cast<size_t>(index) >= twk__num_items()) {
+			return;
+		}
+		if (_twkCtx->items.types[index] == ST_CURVE) {
+			TwkCurve* curve = _twkCtx->items.ptrs[index].curvePtr;
+			if (curve->count == count && memcmp(curve->keys, value, count * sizeof(float)) == 0) {
+				return;
+			}
+			if (!twk__set_curve(curve, static_cast<const float*>(value), count)) {
+				return;
+			}
+		}
+		else {
+			float* ptr = _twkCtx->items.ptrs[index].fPtr;
+			if (memcmp(ptr, value, count * sizeof(float)) == 0) {
+				return;
+			}
+			memcpy(ptr, value, count * sizeof(float));
+		}
+		twk__mark_changed(index);
+		_twkCtx->categories[_twkCtx->items.categories[index]].hashValid = false;
+		TWKSnapshotStore& store = _twkCtx->snapshots;
+		if (store.enabled && _twkCtx->items.info[index].snapshotSlot != -1) {
+			uint32_t sequence = store.sequence.load(std::memory_order_relaxed);
+			store.sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			twk__publish_item(index);
+			store.sequence.store(sequence + 2, std::memory_order_release);
+		}
+		twk__collect_notifications(&index, 1);
+		notify = !_twkCtx->notifications.empty();
+	}
+	if (notify) {
+		twk__dispatch_notifications();
+	}
+}
+
+// -------------------------------------------------------
+// get by handle
+// -------------------------------------------------------
+bool twk_get(TWKContext* ctx, TwkHandle<int> handle, int* value) {
+	TWKScope scope(ctx);
+	if (handle.index < 0 || static_cast<size_t>(handle.index) >= twk__num_items()) {
+		return false;
+	}
+	*value = *_twkCtx->items.ptrs[handle.index].iPtr;
+	return true;
+}
+
+bool twk_get(TWKContext* ctx, TwkHandle<uint32_t> handle, uint32_t* value) {
+	TWKScope scope(ctx);
+	if (handle.index < 0 || static_cast<size_t>(handle.index) >= twk__num_items()) {
+		return false;
+	}
+	*value = *_twkCtx->items.ptrs[handle.index].uiPtr;
+	return true;
+}
+
+bool twk_get(TWKContext* ctx, TwkHandle<float> handle, float* value) {
+	TWKScope scope(ctx);
+	if (handle.index < 0 || static_cast<size_t>(handle.index) >= twk__num_items()) {
+		return false;
+	}
+	*value = *_twkCtx->items.ptrs[handle.index].fPtr;
+	return true;
+}
+
+bool twk_get(TWKContext* ctx, TwkHandle<ds::vec2> handle, ds::vec2* value) {
+	TWKScope scope(ctx);
+	if (handle.index < 0 || static_cast<size_t>(handle.index) >= twk__num_items()) {
+		return false;
+	}
+	*value = *_twkCtx->items.ptrs[handle.index].v2Ptr;
+	return true;
+}
+
+bool twk_get(TWKContext* ctx, TwkHandle<ds::vec3> handle, ds::vec3* value) {
+	TWKScope scope(ctx);
+	if (handle.index < 0 || static_cast<size_t>(handle.index) >= twk__num_items()) {
+		return false;
 	}
+	*value = *_twkCtx->items.ptrs[handle.index].v3Ptr;
+	return true;
+}
+
+bool twk_get(TWKContext* ctx, TwkHandle<ds::vec4> handle, ds::vec4* value) {
+	TWKScope scope(ctx);
+	if (handle.index < 0 || static_cast<size_t>(handle.index) >= twk__num_items()) {
+		return false;
+	}
+	*value = *_twkCtx->items.ptrs[handle.index].v4Ptr;
+	return true;
+}
+
+bool twk_get(TWKContext* ctx, TwkHandle<ds::Color> handle, ds::Color* value) {
+	TWKScope scope(ctx);
+	if (handle.index < 0 || static_cast<size_t>(handle.index) >= twk__num_items()) {
+		return false;
+	}
+	*value = *_twkCtx->items.ptrs[handle.index].cPtr;
+	return true;
+}
+
+bool twk_get(TWKContext* ctx, TwkHandle<float*> handle, float* array, int size) {
+	TWKScope scope(ctx);
+	if (handle.index < 0 || static_cast<size_t>(handle.index) >= twk__num_items()) {
+		return false;
+	}
+	int length = _twkCtx->items.info[handle.index].arrayLength;
+	memcpy(array, _twkCtx->items.ptrs[handle.index].arPtr, (size < length ? size : length) * sizeof(float));
+	return true;
+}
+
+bool twk_get(TWKContext* ctx, TwkHandle<TwkCurve> handle, TwkCurve* curve) {
+	TWKScope scope(ctx);
+	if (handle.index < 0 || static_cast<size_t>(handle.index) >= twk__num_items()) {
+		return false;
+	}
+	*curve = *_twkCtx->items.ptrs[handle.index].curvePtr;
+	return true;
+}
+
+// -------------------------------------------------------
+// set by handle
+// -------------------------------------------------------
+void twk_set(TWKContext* ctx, TwkHandle<int> handle, int value) {
+	TWKScope scope(ctx);
+	twk__set_item(handle.index, &value, 1);
+}
+
+void twk_set(TWKContext* ctx, TwkHandle<uint32_t> handle, uint32_t value) {
+	TWKScope scope(ctx);
+	twk__set_item(handle.index, &value, 1);
+}
+
+void twk_set(TWKContext* ctx, TwkHandle<float> handle, float value) {
+	TWKScope scope(ctx);
+	twk__set_item(handle.index, &value, 1);
+}
+
+void twk_set(TWKContext* ctx, TwkHandle<ds::vec2> handle, const ds::vec2& value) {
+	TWKScope scope(ctx);
+	twk__set_item(handle.index, &value, 2);
+}
+
+void twk_set(TWKContext* ctx, TwkHandle<ds::vec3> handle, const ds::vec3& value) {
+	TWKScope scope(ctx);
+	twk__set_item(handle.index, &value, 3);
+}
+
+void twk_set(TWKContext* ctx, TwkHandle<ds::vec4> handle, const ds::vec4& value) {
+	TWKScope scope(ctx);
+	twk__set_item(handle.index, &value, 4);
+}
+
+void twk_set(TWKContext* ctx, TwkHandle<ds::Color> handle, const ds::Color& value) {
+	TWKScope scope(ctx);
+	twk__set_item(handle.index, &value, 4);
+}
+
+void twk_set(TWKContext* ctx, TwkHandle<float*> handle, const float* array, int size) {
+	TWKScope scope(ctx);
+	if (handle.index >= 0 && static_cast<size_t>(handle.index) < twk__num_items()) {
+		int length = _twkCtx->items.info[handle.index].arrayLength;
+		twk__set_item(handle.index, array, size < length ? size : length);
+	}
+}
+
+// -------------------------------------------------------
+// set the keys of a curve, invalid keys are ignored
+// -------------------------------------------------------
+void twk_set(TWKContext* ctx, TwkHandle<TwkCurve> handle, const float* keys, int count) {
+	TWKScope scope(ctx);
+	twk__set_item(handle.index, keys, count);
+}
+
+// -------------------------------------------------------
+// default context
+// The functions without a context work on the context that
+// was created by twk_init.
+// -------------------------------------------------------
+TwkHandle<int> twk_add(const char* category, const char* name, int* value) {
+	return twk_add(_twkDefault, category, name, value);
+}
+
+TwkHandle<uint32_t> twk_add(const char* category, const char* name, uint32_t* value) {
+	return twk_add(_twkDefault, category, name, value);
+}
+
+TwkHandle<float> twk_add(const char* category, const char* name, float* value) {
+	return twk_add(_twkDefault, category, name, value);
+}
+
+TwkHandle<ds::vec2> twk_add(const char* category, const char* name, ds::vec2* value) {
+	return twk_add(_twkDefault, category, name, value);
+}
+
+TwkHandle<ds::vec3> twk_add(const char* category, const char* name, ds::vec3* value) {
+	return twk_add(_twkDefault, category, name, value);
+}
+
+TwkHandle<ds::vec4> twk_add(const char* category, const char* name, ds::vec4* value) {
+	return twk_add(_twkDefault, category, name, value);
+}
+
+TwkHandle<ds::Color> twk_add(const char* category, const char* name, ds::Color* value) {
+	return twk_add(_twkDefault, category, name, value);
+}
+
+TwkHandle<float*> twk_add(const char* category, const char* name, float* array, int size) {
+	return twk_add(_twkDefault, category, name, array, size);
+}
+
+TwkHandle<TwkCurve> twk_add(const char* category, const char* name, TwkCurve* curve, TwkCurveMode mode, const float* keys, int count) {
+	return twk_add(_twkDefault, category, name, curve, mode, keys, count);
+}
+
+TwkHandle<int> twk_add(const TwkKey& key, int* value) {
+	return twk_add(_twkDefault, key, value);
+}
+
+TwkHandle<uint32_t> twk_add(const TwkKey& key, uint32_t* value) {
+	return twk_add(_twkDefault, key, value);
+}
+
+TwkHandle<float> twk_add(const TwkKey& key, float* value) {
+	return twk_add(_twkDefault, key, value);
+}
+
+TwkHandle<ds::vec2> twk_add(const TwkKey& key, ds::vec2* value) {
+	return twk_add(_twkDefault, key, value);
+}
+
+TwkHandle<ds::vec3> twk_add(const TwkKey& key, ds::vec3* value) {
+	return twk_add(_twkDefault, key, value);
+}
+
+TwkHandle<ds::vec4> twk_add(const TwkKey& key, ds::vec4* value) {
+	return twk_add(_twkDefault, key, value);
+}
+
+TwkHandle<ds::Color> twk_add(const TwkKey& key, ds::Color* value) {
+	return twk_add(_twkDefault, key, value);
+}
+
+TwkHandle<float*> twk_add(const TwkKey& key, float* array, int size) {
+	return twk_add(_twkDefault, key, array, size);
+}
+
+TwkHandle<TwkCurve> twk_add(const TwkKey& key, TwkCurve* curve, TwkCurveMode mode, const float* keys, int count) {
+	return twk_add(_twkDefault, key, curve, mode, keys, count);
+}
+
+void twk_add_struct(const char* const* categories, int count, void* first, size_t stride, const TwkField* fields, int numFields) {
+	twk_add_struct(_twkDefault, categories, count, first, stride, fields, numFields);
+}
+
+void twk_add_struct(const char* category, void* instance, const TwkField* fields, int numFields) {
+	twk_add_struct(_twkDefault, category, instance, fields, numFields);
+}
+
+bool twk_get(const char* category, const char* name, int* value) {
+	return twk_get(_twkDefault, category, name, value);
+}
+
+bool twk_get(const char* category, const char* name, uint32_t* value) {
+	return twk_get(_twkDefault, category, name, value);
+}
+
+bool twk_get(const char* category, const char* name, float* value) {
+	return twk_get(_twkDefault, category, name, value);
+}
+
+bool twk_get(const char* category, const char* name, ds::vec2* value) {
+	return twk_get(_twkDefault, category, name, value);
+}
+
+bool twk_get(const char* category, const char* name, ds::vec3* value) {
+	return twk_get(_twkDefault, category, name, value);
+}
+
+bool twk_get(const char* category, const char* name, ds::vec4* value) {
+	return twk_get(_twkDefault, category, name, value);
+}
+
+bool twk_get(const char* category, const char* name, ds::Color* value) {
+	return twk_get(_twkDefault, category, name, value);
+}
+
+bool twk_get(const char* category, const char* name, float* array, int size) {
+	return twk_get(_twkDefault, category, name, array, size);
+}
+
+bool twk_get(const TwkKey& key, int* value) {
+	return twk_get(_twkDefault, key, value);
+}
+
+bool twk_get(const TwkKey& key, uint32_t* value) {
+	return twk_get(_twkDefault, key, value);
+}
+
+bool twk_get(const TwkKey& key, float* value) {
+	return twk_get(_twkDefault, key, value);
+}
+
+bool twk_get(const TwkKey& key, ds::vec2* value) {
+	return twk_get(_twkDefault, key, value);
+}
+
+bool twk_get(const TwkKey& key, ds::vec3* value) {
+	return twk_get(_twkDefault, key, value);
+}
+
+bool twk_get(const TwkKey& key, ds::vec4* value) {
+	return twk_get(_twkDefault, key, value);
+}
+
+bool twk_get(const TwkKey& key, ds::Color* value) {
+	return twk_get(_twkDefault, key, value);
+}
+
+bool twk_get(const TwkKey& key, float* array, int size) {
+	return twk_get(_twkDefault, key, array, size);
+}
+
+bool twk_save() {
+	return twk_save(_twkDefault);
 }
 
-// -------------------------------------------------------
-// settings item
-// -------------------------------------------------------
-static bool twk__get_filetime(const char* fileName, FILETIME* time) {
-	WORD ret = -1;
-	// no file sharing mode
-	HANDLE hFile = CreateFile(fileName, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
-	if (hFile != INVALID_HANDLE_VALUE) {
-		// Retrieve the file times for the file.
-		GetFileTime(hFile, NULL, NULL, time);
-		CloseHandle(hFile);
-		return true;
-	}
-	return false;
+bool twk_save(const char* fileName) {
+	return twk_save(_twkDefault, fileName);
 }
 
-// -------------------------------------------------------
-// internal load file
-// -------------------------------------------------------
-static char* twk__load_file(const char* fileName, FILETIME* time) {
-	int size = 0;
-	FILE *fp = fopen(fileName, "r");
-	if (fp) {
-		fseek(fp, 0, SEEK_END);
-		int sz = ftell(fp);
-		fseek(fp, 0, SEEK_SET);
-		char* buffer = new char[sz + 1];
-		fread(buffer, 1, sz, fp);
-		buffer[sz] = '\0';
-		fclose(fp);
-		twk__get_filetime(fileName, time);
-		return buffer;
-	}
-	else {
-		twk__report_error("Cannot load file: '%s'", fileName);
-	}
-	return 0;
+TwkStats twk_stats() {
+	return twk_stats(_twkDefault);
 }
-/*
- * The idea is taken from https://github.com/chadaustin/sajson/blob/master/include/sajson.h
- * bit 1 = digit
- * bit 2 = numeric
- * bit 3 = name
- * bit 4 = whitespace
- * bit 5 = supported
-*/
-const uint8_t PARSE_FLAGS[256] = {
-	0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 8, 0, 0, 8, 0, 0,  
-	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  
-	8, 0, 0,16, 0, 0, 0, 0, 0, 0, 0, 1,16, 1, 1, 0, 
-	3, 3, 3, 3, 3, 3, 3, 3, 3, 3,16, 0, 0, 0, 0, 0, 
-	0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
-	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 0, 0, 0,16, 4,
-	0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
-	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,16, 0,16, 0, 0,
-	// 128-255 -> we do not support any character >= 128
-	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-};
 
-static bool inline twk__is_supported(const char c) {
-	return (PARSE_FLAGS[static_cast<unsigned char>(c)]) > 0;
+void twk_enable_trace(int maxEvents) {
+	twk_enable_trace(_twkDefault, maxEvents);
 }
-// -------------------------------------------------------
-// internal is digit
-// -------------------------------------------------------
-static bool  inline twk__is_digit(const char c) {
-	return (PARSE_FLAGS[static_cast<unsigned char>(c)] & 1) != 0;
+
+bool twk_write_trace(const char* fileName) {
+	return twk_write_trace(_twkDefault, fileName);
 }
 
-// -------------------------------------------------------
-// internal is numeric
-// -------------------------------------------------------
-static bool  inline twk__is_numeric(const char c) {
-	return (PARSE_FLAGS[static_cast<unsigned char>(c)] & 2) != 0;
+void twk_parse(const char* text) {
+	twk_parse(_twkDefault, text);
 }
 
-// -------------------------------------------------------
-// internal is name char
-// -------------------------------------------------------
-static bool  inline twk__is_name(const char c) {
-	return (PARSE_FLAGS[static_cast<unsigned char>(c)] & 4) != 0;
+void twk_start_background_reload() {
+	twk_start_background_reload(_twkDefault);
 }
-// -------------------------------------------------------
-// internal is whitespace
-// -------------------------------------------------------
-static bool  inline twk__is_whitespace(const char c) {
-	return (PARSE_FLAGS[static_cast<unsigned char>(c)] & 8) != 0;
+
+bool twk_apply_pending() {
+	return twk_apply_pending(_twkDefault);
 }
 
-// -------------------------------------------------------
-// internal string to float
-// -------------------------------------------------------
-static float twk__strtof(const char* p, char** endPtr) {
-	while (twk__is_whitespace(*p)) {
-		++p;
-	}
-	float sign = 1.0f;
-	if (*p == '-') {
-		sign = -1.0f;
-		++p;
-	}
-	else if (*p == '+') {
-		++p;
-	}
-	float value = 0.0f;
-	while (twk__is_numeric(*p)) {
-		value *= 10.0f;
-		value = value + (*p - '0');
-		++p;
-	}
-	if (*p == '.') {
-		++p;
-		float dec = 1.0f;
-		float frac = 0.0f;
-		while (twk__is_numeric(*p)) {
-			frac *= 10.0f;
-			frac = frac + (*p - '0');
-			dec *= 10.0f;
-			++p;
-		}
-		value = value + (frac / dec);
-	}
-	if (endPtr) {
-		*endPtr = (char *)(p);
-	}
-	return value * sign;
+void twk_enable_snapshots() {
+	twk_enable_snapshots(_twkDefault);
 }
 
-// -------------------------------------------------------
-// internal find variable
-// -------------------------------------------------------
-static int twk__find(int categoryIndex, const char* name) {
-	uint32_t hash = twk_fnv1a(name);
-	for (size_t i = 0; i < _twkCtx->items.size(); ++i) {
-		if (_twkCtx->items[i].hash == hash && _twkCtx->items[i].categoryIndex == categoryIndex) {
-			return i;
-		}
-	}
-	return -1;
+void twk_snapshot_publish() {
+	twk_snapshot_publish(_twkDefault);
 }
 
-// -------------------------------------------------------
-// internal set value
-// -------------------------------------------------------
-static void twk__set_value(int categoryIndex, const char* name, int nameIndex, int length, float* values, int count) {
-	int idx = twk__find(categoryIndex, name);
-	if (idx != -1) {
-		InternalTweakable& item = _twkCtx->items[idx];
-		item.nameIndex = nameIndex;
-		item.length = length;
-		if (item.type == TweakableType::ST_INT && count == 1) {
-			*item.ptr.iPtr = static_cast<int>(values[0]);
-			item.found = true;
-		}
-		else if (item.type == TweakableType::ST_UINT && count == 1) {
-			*item.ptr.uiPtr = static_cast<uint32_t>(values[0]);
-			item.found = true;
-		}
-		else if (item.type == TweakableType::ST_FLOAT && count == 1) {
-			*item.ptr.fPtr = values[0];
-			item.found = true;
-		}
-		else if (item.type == TweakableType::ST_VEC2 && count == 2) {
-			item.ptr.v2Ptr->x = values[0];
-			item.ptr.v2Ptr->y = values[1];
-			item.found = true;
-		}
-		else if (item.type == TweakableType::ST_VEC3 && count == 3) {
-			item.ptr.v3Ptr->x = values[0];
-			item.ptr.v3Ptr->y = values[1];
-			item.ptr.v3Ptr->z = values[2];
-			item.found = true;
-		}
-		else if (item.type == TweakableType::ST_VEC4 && count == 4) {
-			item.ptr.v4Ptr->x = values[0];
-			item.ptr.v4Ptr->y = values[1];
-			item.ptr.v4Ptr->z = values[2];
-			item.ptr.v4Ptr->w = values[3];
-			item.found = true;
-		}
-		else if (item.type == TweakableType::ST_COLOR && count == 4) {
-			for (int i = 0; i < 4; ++i) {
-				item.ptr.cPtr->data[i] = values[i] / 255.0f;
-			}
-			item.found = true;
-		}
-		else if (item.type == TweakableType::ST_ARRAY && count == item.arrayLength) {
-			for (int i = 0; i < count; ++i) {
-				item.ptr.arPtr[i] = values[i];
-			}
-			item.found = true;
-		}
-	}
-	else {
-		// create internal one as array -> need to store data somewhere (but where????)
-	}
+TwkSnapshotRef twk_snapshot_ref(const char* category, const char* name) {
+	return twk_snapshot_ref(_twkDefault, category, name);
 }
 
-// -------------------------------------------------------
-// internal check if the file should be (re)loaded
-// -------------------------------------------------------
-static bool twk__requires_loading() {
-	if (!_twkCtx->loaded) {
-		return true;
-	}
-	FILETIME now;
-	if (twk__get_filetime(_twkCtx->fileName, &now)) {
-		if (CompareFileTime(&_twkCtx->filetime, &now) == -1) {
-			_twkCtx->filetime = now;
-			return true;
-		}
-	}
-	return false;
+uint32_t twk_snapshot_begin() {
+	return twk_snapshot_begin(_twkDefault);
 }
 
-// -------------------------------------------------------
-// internal check if the file should be (re)loaded
-// -------------------------------------------------------
-void twk_parse(const char* text) {
-	// FIXME: reset internal char buffer - keep the already allocated memory
-	// do not clear added variables
-	//_settingsCtx->charBuffer.count = 0;
-	//_settingsCtx->charBuffer.size = 0;
-	// reset found to false for every item
-	for (size_t i = 0; i < _twkCtx->items.size(); ++i) {
-		_twkCtx->items[i].found = false;
-	}
-	const char* p = text;
-	std::vector<TWKToken> tokens;
-	while (*p != 0) {
-		TWKToken token(TWKToken::EMPTY);
-		if (twk__is_supported(*p)) {
-			if (twk__is_digit(*p)) {
-				char *out;
-				token = TWKToken(TWKToken::NUMBER, twk__strtof(p, &out));
-				p = out;
-			}
-			else if (twk__is_name(*p)) {
-				const char *identifier = p;
-				while (twk__is_name(*p)) {
-					p++;
-				}
-				token = TWKToken(TWKToken::NAME, identifier - text, p - identifier);
-			}
-			else if (*p == '#') {
-				++p;
-				while (*p != '\n') {
-					++p;
-					if (*p == 0) {
-						break;
-					}
-				}
-			}
-			else {
-				switch (*p) {
-				case '{': token = TWKToken(TWKToken::OPEN_BRACES); break;
-				case '}': token = TWKToken(TWKToken::CLOSE_BRACES); break;
-				case ' ': case '\t': case '\n': case '\r': break;
-				case ':': token = TWKToken(TWKToken::ASSIGN); break;
-				case ',': token = TWKToken(TWKToken::DELIMITER); break;
-				}
-				++p;
-			}
-			if (token.type != TWKToken::EMPTY) {
-				tokens.push_back(token);
-			}
-		}
-		else {
-			++p;
-		}
-	}
-	int idx = 0;
-	TWKToken& t = tokens[idx];
-	char name[128];
-	float values[128];
-	int currentCategory = -1;
-	int currentName = -1;
-	while (idx < tokens.size()) {
-		if (t.type == TWKToken::NAME) {
-			strncpy(name, text + t.index, t.size);
-			name[t.size] = '\0';
-			++idx;
-			TWKToken& n = tokens[idx];
-			if (n.type == TWKToken::OPEN_BRACES) {
-				int cidx = twk__find_category(name);
-				if (cidx == -1) {
-					TWKCategory cat;
-					cat.hash = twk_fnv1a(name);
-					cat.nameIndex = twk__add_string(name);
-					_twkCtx->categories.push_back(cat);
-					currentCategory = static_cast<int>(_twkCtx->categories.size()) - 1;
-				}		
-				else {
-					currentCategory = cidx;
-				}
-			}
-			else if (n.type == TWKToken::ASSIGN) {
-				int strIdx = twk__add_string(name);
-				++idx;
-				TWKToken& v = tokens[idx];
-				int count = 0;
-				while (v.type == TWKToken::NUMBER || v.type == TWKToken::DELIMITER) {
-					if (v.type == TWKToken::NUMBER) {
-						if (count < 128) {
-							values[count++] = v.value;
-						}
-					}
-					++idx;
-					if (idx >= tokens.size()) {
-						break;
-					}
-					v = tokens[idx];
-				}
-				twk__set_value(currentCategory, name, strIdx, t.size, values, count);
-			}
-			else {
-				++idx;
-			}
-		}
-		else {
-			++idx;
-		}
-		if (idx < tokens.size()) {
-			t = tokens[idx];
-		}
-	}
-	for (size_t i = 0; i < _twkCtx->items.size(); ++i) {
-		const InternalTweakable& item = _twkCtx->items[i];
-		if (!item.found) {
-			char* in = twk__get_string(item.nameIndex);
-			twk__report_error("Item '%s' not found", in);
-		}
-	}
+void twk_snapshot_load(const TwkSnapshotRef& ref, void* dest) {
+	twk_snapshot_load(_twkDefault, ref, dest);
+}
+
+bool twk_snapshot_retry(uint32_t sequence) {
+	return twk_snapshot_retry(_twkDefault, sequence);
+}
+
+bool twk_snapshot_read(const TwkSnapshotRef& ref, void* dest) {
+	return twk_snapshot_read(_twkDefault, ref, dest);
 }
 
-// -------------------------------------------------------
-// load
-// -------------------------------------------------------
 bool twk_load() {
-	if (twk__requires_loading() && _twkCtx->reloadable) {
-		_twkCtx->loaded = true;
-		int cnt = 0;
-		const char* _text = twk__load_file(_twkCtx->fileName, &_twkCtx->filetime);
-		if (_text != 0) {
-			twk_parse(_text);
-			delete[] _text;
-			return true;
-		}
-		return false;
-	}
-	return false;
+	return twk_load(_twkDefault);
+}
+
+bool twk_load_many(const char* const* files, int count) {
+	return twk_load_many(_twkDefault, files, count);
+}
+
+bool twk_load_binary(const void* data, size_t size) {
+	return twk_load_binary(_twkDefault, data, size);
+}
+
+bool twk_load_binary(const char* fileName) {
+	return twk_load_binary(_twkDefault, fileName);
 }
 
-// -------------------------------------------------------
-// verify that all items were found
-// -------------------------------------------------------
 bool twk_verify() {
-	for (size_t i = 0; i < _twkCtx->items.size(); ++i) {
-		const InternalTweakable& item = _twkCtx->items[i];
-		if (!item.found) {
-			return false;
-		}
-	}
-	return true;
+	return twk_verify(_twkDefault);
 }
 
-// -------------------------------------------------------
-// number of categories
-// -------------------------------------------------------
 int twk_num_categories() {
-	return _twkCtx->categories.size();
+	return twk_num_categories(_twkDefault);
 }
 
-// -------------------------------------------------------
-// category name 
-// -------------------------------------------------------
 const char* twk_get_category_name(int index) {
-	const TWKCategory c = _twkCtx->categories[index];
-	int idx = c.nameIndex;
-	int offset = _twkCtx->charBuffer.indices[idx];
-	const char* name = _twkCtx->charBuffer.data + offset;
-	return _twkCtx->charBuffer.data + offset;
+	return twk_get_category_name(_twkDefault, index);
 }
 
-// -------------------------------------------------------
-// all tweakbales for one category
-// -------------------------------------------------------
 int twk_get_tweakables(int categoryIndex, Tweakable* ret, int max) {
-	int cnt = 0;
-	for (size_t i = 0; i < _twkCtx->items.size(); ++i) {
-		const InternalTweakable& item = _twkCtx->items[i];
-		if (item.categoryIndex == categoryIndex && cnt < max) {
-			Tweakable& t = ret[cnt++];
-			t.type = item.type;
-			switch (item.type) {
-				case ST_FLOAT: t.ptr.fPtr = item.ptr.fPtr; break;
-				case ST_INT: t.ptr.iPtr = item.ptr.iPtr; break;
-				case ST_UINT: t.ptr.uiPtr = item.ptr.uiPtr; break;
-				case ST_VEC2: t.ptr.v2Ptr = item.ptr.v2Ptr; break;
-				case ST_VEC3: t.ptr.v3Ptr = item.ptr.v3Ptr; break;
-				case ST_VEC4: t.ptr.v4Ptr = item.ptr.v4Ptr; break;
-				case ST_COLOR: t.ptr.cPtr = item.ptr.cPtr; break;
-				case ST_ARRAY: t.ptr.arPtr = item.ptr.arPtr; break;
-			}
-			t.arrayLength = item.arrayLength;
-			int nidx = item.nameIndex;
-			int offset = _twkCtx->charBuffer.indices[nidx];
-			t.name = _twkCtx->charBuffer.data + offset;
-		}
-	}
-	return cnt;
+	return twk_get_tweakables(_twkDefault, categoryIndex, ret, max);
 }
 
-// -------------------------------------------------------
-// all tweakbales for one category
-// -------------------------------------------------------
 int twk_get_tweakables(const char* category, Tweakable* ret, int max) {
-	int cid = twk__find_category(category);
-	int cnt = 0;
-	if (cid != -1) {		
-		for (size_t i = 0; i < _twkCtx->items.size(); ++i) {
-			const InternalTweakable& item = _twkCtx->items[i];
-			if (item.categoryIndex == cid && cnt < max) {
-				Tweakable& t = ret[cnt++];
-				t.type = item.type;
-				switch (item.type) {
-				case ST_FLOAT: t.ptr.fPtr = item.ptr.fPtr; break;
-				case ST_INT: t.ptr.iPtr = item.ptr.iPtr; break;
-				case ST_UINT: t.ptr.uiPtr = item.ptr.uiPtr; break;
-				case ST_VEC2: t.ptr.v2Ptr = item.ptr.v2Ptr; break;
-				case ST_VEC3: t.ptr.v3Ptr = item.ptr.v3Ptr; break;
-				case ST_VEC4: t.ptr.v4Ptr = item.ptr.v4Ptr; break;
-				case ST_COLOR: t.ptr.cPtr = item.ptr.cPtr; break;
-				case ST_ARRAY: t.ptr.arPtr = item.ptr.arPtr; break;
-				}
-				t.arrayLength = item.arrayLength;
-				int nidx = item.nameIndex;
-				int offset = _twkCtx->charBuffer.indices[nidx];
-				t.name = _twkCtx->charBuffer.data + offset;
-			}
-		}
-	}
-	return cnt;
+	return twk_get_tweakables(_twkDefault, category, ret, max);
+}
+
+int twk_get_changed_categories(int* ret, int max) {
+	return twk_get_changed_categories(_twkDefault, ret, max);
+}
+
+int twk_get_changed_tweakables(Tweakable* ret, int max) {
+	return twk_get_changed_tweakables(_twkDefault, ret, max);
+}
+
+void twk_on_change(const char* category, const char* name, twkChangeCallback callback, void* user) {
+	twk_on_change(_twkDefault, category, name, callback, user);
+}
+
+void twk_on_change(const char* category, twkChangeCallback callback, void* user) {
+	twk_on_change(_twkDefault, category, callback, user);
+}
+
+bool twk_get(TwkHandle<int> handle, int* value) {
+	return twk_get(_twkDefault, handle, value);
+}
+
+bool twk_get(TwkHandle<uint32_t> handle, uint32_t* value) {
+	return twk_get(_twkDefault, handle, value);
+}
+
+bool twk_get(TwkHandle<float> handle, float* value) {
+	return twk_get(_twkDefault, handle, value);
+}
+
+bool twk_get(TwkHandle<ds::vec2> handle, ds::vec2* value) {
+	return twk_get(_twkDefault, handle, value);
+}
+
+bool twk_get(TwkHandle<ds::vec3> handle, ds::vec3* value) {
+	return twk_get(_twkDefault, handle, value);
+}
+
+bool twk_get(TwkHandle<ds::vec4> handle, ds::vec4* value) {
+	return twk_get(_twkDefault, handle, value);
+}
+
+bool twk_get(TwkHandle<ds::Color> handle, ds::Color* value) {
+	return twk_get(_twkDefault, handle, value);
+}
+
+bool twk_get(TwkHandle<float*> handle, float* array, int size) {
+	return twk_get(_twkDefault, handle, array, size);
+}
+
+bool twk_get(TwkHandle<TwkCurve> handle, TwkCurve* curve) {
+	return twk_get(_twkDefault, handle, curve);
+}
+
+void twk_set(TwkHandle<int> handle, int value) {
+	twk_set(_twkDefault, handle, value);
+}
+
+void twk_set(TwkHandle<uint32_t> handle, uint32_t value) {
+	twk_set(_twkDefault, handle, value);
+}
+
+void twk_set(TwkHandle<float> handle, float value) {
+	twk_set(_twkDefault, handle, value);
+}
+
+void twk_set(TwkHandle<ds::vec2> handle, const ds::vec2& value) {
+	twk_set(_twkDefault, handle, value);
+}
+
+void twk_set(TwkHandle<ds::vec3> handle, const ds::vec3& value) {
+	twk_set(_twkDefault, handle, value);
+}
+
+void twk_set(TwkHandle<ds::vec4> handle, const ds::vec4& value) {
+	twk_set(_twkDefault, handle, value);
+}
+
+void twk_set(TwkHandle<ds::Color> handle, const ds::Color& value) {
+	twk_set(_twkDefault, handle, value);
+}
+
+void twk_set(TwkHandle<float*> handle, const float* array, int size) {
+	twk_set(_twkDefault, handle, array, size);
+}
+
+void twk_set(TwkHandle<TwkCurve> handle, const float* keys, int count) {
+	twk_set(_twkDefault, handle, keys, count);
 }
 
 #endif // GAMESETTINGS_IMPLEMENTATION
\ No newline at end of file
@@ -0,0 +1,368 @@
+// -------------------------------------------------------
+// benchmark - portable performance suite
+//
+// Generates synthetic settings from 100 up to 1M keys and
+// measures tokenizing, parsing and applying, lookups, saving
+// and reloading separately. Every result is one CSV line on
+// stdout so runs can be compared by a script.
+//
+// usage: benchmark [max keys] [comment density]
+//
+// g++ -std=c++11 -O2 -I<path to diesel> test/benchmark.cpp -o benchmark -lpthread
+// -------------------------------------------------------
+#define GAMESETTINGS_IMPLEMENTATION
+#include "../ds_tweakable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double elapsedNs(BenchClock::time_point start) {
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count());
+}
+
+static uint32_t nextRandom(uint32_t* state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+// names must not contain digits
+static void buildName(char* buffer, const char* prefix, int index) {
+	int l = sprintf(buffer, "%s", prefix);
+	do {
+		buffer[l++] = 'a' + index % 26;
+		index /= 26;
+	} while (index > 0);
+	buffer[l] = '\0';
+}
+
+static void onError(const char*) {
+}
+
+// -------------------------------------------------------
+// synthetic settings
+// Categories hold between 10 and 200 keys. Half of the keys
+// are floats, the rest are ints, vectors, colors and arrays
+// of 4 to 16 values. commentDensity is the chance of a
+// comment line before every key.
+// -------------------------------------------------------
+struct BenchKey {
+	std::string category;
+	std::string name;
+	TweakableType type;
+	int offset;
+	int count;
+};
+
+struct BenchSettings {
+	std::vector<BenchKey> keys;
+	std::vector<float> storage;
+	std::string text[2];
+};
+
+static int appendValues(std::string* text, const BenchKey& key, uint32_t* state, int variant) {
+	char buffer[64];
+	for (int i = 0; i < key.count; ++i) {
+		uint32_t r = nextRandom(state);
+		if (key.type == ST_INT) {
+			sprintf(buffer, "%d", static_cast<int>(r % 20000) - 10000 + variant);
+		}
+		else if (key.type == ST_COLOR) {
+			sprintf(buffer, "%d", static_cast<int>((r + variant) % 256));
+		}
+		else {
+			sprintf(buffer, "%d.%03d", static_cast<int>(r % 2000) - 1000, static_cast<int>((r >> 12) % 1000 + variant) % 1000);
+		}
+		if (i != 0) {
+			*text += ", ";
+		}
+		*text += buffer;
+	}
+	return key.count;
+}
+
+static void generateSettings(BenchSettings* settings, int numKeys, float commentDensity, uint32_t seed) {
+	uint32_t state = seed;
+	char category[32];
+	char name[32];
+	int values = 0;
+	int categoryIndex = 0;
+	while (static_cast<int>(settings->keys.size()) < numKeys) {
+		buildName(category, "category_", categoryIndex++);
+		int size = 10 + static_cast<int>(nextRandom(&state) % 191);
+		for (int i = 0; i < size && static_cast<int>(settings->keys.size()) < numKeys; ++i) {
+			BenchKey key;
+			buildName(name, "key_", i);
+			key.category = category;
+			key.name = name;
+			uint32_t r = nextRandom(&state) % 100;
+			if (r < 50) {
+				key.type = ST_FLOAT;
+				key.count = 1;
+			}
+			else if (r < 60) {
+				key.type = ST_INT;
+				key.count = 1;
+			}
+			else if (r < 70) {
+				key.type = ST_VEC2;
+				key.count = 2;
+			}
+			else if (r < 78) {
+				key.type = ST_VEC3;
+				key.count = 3;
+			}
+			else if (r < 83) {
+				key.type = ST_VEC4;
+				key.count = 4;
+			}
+			else if (r < 90) {
+				key.type = ST_COLOR;
+				key.count = 4;
+			}
+			else {
+				key.type = ST_ARRAY;
+				key.count = 4 + static_cast<int>(nextRandom(&state) % 13);
+			}
+			key.offset = values;
+			values += key.count;
+			settings->keys.push_back(key);
+		}
+	}
+	settings->storage.assign(values, 0.0f);
+	// both variants differ in every value so parsing them in turn applies everything
+	for (int v = 0; v < 2; ++v) {
+		std::string& text = settings->text[v];
+		uint32_t valueState = seed ^ 0x9E3779B9;
+		uint32_t commentState = seed ^ 0x85EBCA6B;
+		const std::string* current = 0;
+		for (size_t i = 0; i < settings->keys.size(); ++i) {
+			const BenchKey& key = settings->keys[i];
+			if (current == 0 || *current != key.category) {
+				if (current != 0) {
+					text += "}\n";
+				}
+				text += key.category;
+				text += " {\n";
+				current = &key.category;
+			}
+			if ((nextRandom(&commentState) % 1000) < static_cast<uint32_t>(commentDensity * 1000.0f)) {
+				text += "\t# tuned by hand - do not change without talking to design\n";
+			}
+			text += "\t";
+			text += key.name;
+			text += " : ";
+			appendValues(&text, key, &valueState, v);
+			text += "\n";
+		}
+		text += "}\n";
+	}
+}
+
+static void registerSettings(TWKContext* ctx, BenchSettings* settings, std::vector<TwkHandle<float> >* handles) {
+	float* storage = settings->storage.data();
+	for (size_t i = 0; i < settings->keys.size(); ++i) {
+		const BenchKey& key = settings->keys[i];
+		const char* c = key.category.c_str();
+		const char* n = key.name.c_str();
+		float* ptr = storage + key.offset;
+		switch (key.type) {
+			case ST_FLOAT: {
+				TwkHandle<float> handle = twk_add(ctx, c, n, ptr);
+				if (handles != 0) {
+					handles->push_back(handle);
+				}
+				break;
+			}
+			case ST_INT: twk_add(ctx, c, n, reinterpret_cast<int*>(ptr)); break;
+			case ST_VEC2: twk_add(ctx, c, n, reinterpret_cast<ds::vec2*>(ptr)); break;
+			case ST_VEC3: twk_add(ctx, c, n, reinterpret_cast<ds::vec3*>(ptr)); break;
+			case ST_VEC4: twk_add(ctx, c, n, reinterpret_cast<ds::vec4*>(ptr)); break;
+			case ST_COLOR: twk_add(ctx, c, n, reinterpret_cast<ds::Color*>(ptr)); break;
+			default: twk_add(ctx, c, n, ptr, key.count); break;
+		}
+	}
+}
+
+static void writeFile(const char* fileName, const std::string& text) {
+	FILE* fp = fopen(fileName, "wb");
+	if (fp) {
+		fwrite(text.data(), 1, text.size(), fp);
+		fclose(fp);
+	}
+}
+
+// -------------------------------------------------------
+// results
+// The median of all repetitions is reported.
+// -------------------------------------------------------
+static double median(std::vector<double>* samples) {
+	std::sort(samples->begin(), samples->end());
+	return (*samples)[samples->size() / 2];
+}
+
+static void report(const char* name, int keys, float commentDensity, size_t bytes, size_t operations, std::vector<double>* samples) {
+	double ns = median(samples);
+	printf("%s,%d,%.2f,%d,%d,%.0f,%.2f,%.1f\n", name, keys, commentDensity, static_cast<int>(bytes), static_cast<int>(samples->size()),
+		ns, ns / operations, bytes > 0 ? bytes / ns * 1000.0 : 0.0);
+	fflush(stdout);
+}
+
+static void runBenchmark(int numKeys, float commentDensity) {
+	BenchSettings settings;
+	generateSettings(&settings, numKeys, commentDensity, 0x12345678u + numKeys);
+	const std::string& text = settings.text[0];
+	size_t bytes = text.size();
+	int repetitions = std::max(3, std::min(25, 2000000 / numKeys));
+	std::vector<double> samples;
+
+	// tokenize only
+	int tokens = 0;
+	for (int r = 0; r < repetitions; ++r) {
+		BenchClock::time_point start = BenchClock::now();
+		const char* begin = text.c_str();
+		const char* end = begin + bytes;
+		TWKToken t;
+		const char* p = twk__next_token(begin, begin, end, &t);
+		tokens = 0;
+		while (t.type != TWKToken::EMPTY) {
+			++tokens;
+			p = twk__next_token(begin, p, end, &t);
+		}
+		samples.push_back(elapsedNs(start));
+	}
+	report("tokenize", numKeys, commentDensity, bytes, tokens, &samples);
+
+	// first parse into an empty context and parsing the variants in turn
+	std::vector<TwkHandle<float> > handles;
+	TWKContext* ctx = twk_create(&onError);
+	registerSettings(ctx, &settings, &handles);
+	samples.clear();
+	BenchClock::time_point start = BenchClock::now();
+	twk_parse(ctx, text.c_str());
+	samples.push_back(elapsedNs(start));
+	report("parse_first", numKeys, commentDensity, bytes, numKeys, &samples);
+	samples.clear();
+	for (int r = 0; r < repetitions; ++r) {
+		const std::string& variant = settings.text[(r + 1) % 2];
+		start = BenchClock::now();
+		twk_parse(ctx, variant.c_str());
+		samples.push_back(elapsedNs(start));
+	}
+	report("parse_apply", numKeys, commentDensity, bytes, numKeys, &samples);
+	samples.clear();
+	for (int r = 0; r < repetitions; ++r) {
+		start = BenchClock::now();
+		twk_parse(ctx, settings.text[repetitions % 2].c_str());
+		samples.push_back(elapsedNs(start));
+	}
+	report("parse_unchanged", numKeys, commentDensity, bytes, numKeys, &samples);
+
+	// lookups in random order
+	std::vector<int> order;
+	for (size_t i = 0; i < settings.keys.size(); ++i) {
+		if (settings.keys[i].type == ST_FLOAT) {
+			order.push_back(static_cast<int>(i));
+		}
+	}
+	uint32_t state = 0xCAFEBABE;
+	for (size_t i = order.size(); i > 1; --i) {
+		std::swap(order[i - 1], order[nextRandom(&state) % i]);
+	}
+	float sum = 0.0f;
+	samples.clear();
+	for (int r = 0; r < repetitions; ++r) {
+		start = BenchClock::now();
+		for (size_t i = 0; i < order.size(); ++i) {
+			const BenchKey& key = settings.keys[order[i]];
+			float v = 0.0f;
+			twk_get(ctx, key.category.c_str(), key.name.c_str(), &v);
+			sum += v;
+		}
+		samples.push_back(elapsedNs(start));
+	}
+	report("lookup_name", numKeys, commentDensity, 0, order.size(), &samples);
+	samples.clear();
+	for (int r = 0; r < repetitions; ++r) {
+		start = BenchClock::now();
+		for (size_t i = 0; i < handles.size(); ++i) {
+			float v = 0.0f;
+			twk_get(ctx, handles[(i * 7919) % handles.size()], &v);
+			sum += v;
+		}
+		samples.push_back(elapsedNs(start));
+	}
+	report("lookup_handle", numKeys, commentDensity, 0, handles.size(), &samples);
+
+	// save
+	const char* saveName = "benchmark_save.txt";
+	samples.clear();
+	for (int r = 0; r < repetitions; ++r) {
+		start = BenchClock::now();
+		twk_save(ctx, saveName);
+		samples.push_back(elapsedNs(start));
+	}
+	FILE* fp = fopen(saveName, "rb");
+	size_t saved = 0;
+	if (fp) {
+		fseek(fp, 0, SEEK_END);
+		saved = static_cast<size_t>(ftell(fp));
+		fclose(fp);
+	}
+	report("save", numKeys, commentDensity, saved, numKeys, &samples);
+	remove(saveName);
+	twk_destroy(ctx);
+
+	// reload - only the twk_load call that picks up the change is measured
+	const char* fileName = "benchmark_settings.txt";
+	writeFile(fileName, settings.text[0]);
+	ctx = twk_create(fileName, &onError);
+	registerSettings(ctx, &settings, 0);
+	twk_load(ctx);
+	samples.clear();
+	int reloads = std::min(repetitions, 10);
+	for (int r = 0; r < reloads; ++r) {
+		writeFile(fileName, settings.text[(r + 1) % 2]);
+		for (int i = 0; i < 500; ++i) {
+			start = BenchClock::now();
+			if (twk_load(ctx)) {
+				samples.push_back(elapsedNs(start));
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+	}
+	if (!samples.empty()) {
+		report("reload", numKeys, commentDensity, bytes, numKeys, &samples);
+	}
+	twk_destroy(ctx);
+	remove(fileName);
+	if (sum == 12345.0f) {
+		printf("\n");
+	}
+}
+
+int main(int argc, char** argv) {
+	int maxKeys = argc > 1 ? atoi(argv[1]) : 1000000;
+	float commentDensity = argc > 2 ? static_cast<float>(atof(argv[2])) : -1.0f;
+	printf("benchmark,keys,comments,bytes,repetitions,median_ns,ns_per_op,mb_per_s\n");
+	for (int keys = 100; keys <= maxKeys; keys *= 10) {
+		if (commentDensity >= 0.0f) {
+			runBenchmark(keys, commentDensity);
+		}
+		else {
+			runBenchmark(keys, 0.0f);
+			runBenchmark(keys, 0.5f);
+		}
+	}
+	return 0;
+}
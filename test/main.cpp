@@ -1,6 +1,11 @@
 #define GAMESETTINGS_IMPLEMENTATION
 #include "..\ds_tweakable.h"
 #include "PerfTimer.h"
+#include <math.h>
+#include <thread>
+#include <chrono>
+#include <string>
+#include <locale.h>
 
 struct CatTest {
 	float value;
@@ -64,6 +69,1522 @@ void categoryTest() {
 	twk_shutdown();
 }
 
+// -------------------------------------------------------
+// names may not contain digits so encode the index as letters
+// -------------------------------------------------------
+void buildName(char* buffer, const char* prefix, int index) {
+	int l = sprintf(buffer, "%s", prefix);
+	do {
+		buffer[l++] = 'a' + index % 26;
+		index /= 26;
+	} while (index > 0);
+	buffer[l] = '\0';
+}
+
+// -------------------------------------------------------
+// builds a settings text with num items spread over
+// categories of 100 items each and registers all of them
+// -------------------------------------------------------
+char* buildScalingSettings(int num, float* values, TWKContext* ctx = 0) {
+	char* text = new char[num * 32 + 64];
+	char* p = text;
+	char category[32];
+	char name[32];
+	for (int i = 0; i < num; ++i) {
+		buildName(category, "cat_", i / 100);
+		buildName(name, "value_", i % 100);
+		if (i % 100 == 0) {
+			if (i != 0) {
+				p += sprintf(p, "}\n");
+			}
+			p += sprintf(p, "%s {\n", category);
+		}
+		p += sprintf(p, "\t%s : %d.5\n", name, i);
+		if (ctx != 0) {
+			twk_add(ctx, category, name, &values[i]);
+		}
+		else {
+			twk_add(category, name, &values[i]);
+		}
+	}
+	p += sprintf(p, "}\n");
+	return text;
+}
+
+void reloadScalingTest() {
+	const int SIZES[3] = { 1000, 10000, 100000 };
+	for (int s = 0; s < 3; ++s) {
+		int num = SIZES[s];
+		twk_init(&errorHandler);
+		float* values = new float[num];
+		char* text = buildScalingSettings(num, values);
+		PerfTimer timer;
+		timer.start();
+		twk_parse(text);
+		double elapsed = timer.stop();
+		printf("items: %6d reload: %10.1f microseconds (%.3f per item)\n", num, elapsed, elapsed / num);
+		if (!twk_verify() || values[num - 1] != (num - 1) + 0.5f) {
+			printf("ERROR - not valid\n");
+		}
+		delete[] text;
+		delete[] values;
+		twk_shutdown();
+	}
+}
+
+// -------------------------------------------------------
+// truncated and empty input must not read past the end
+// -------------------------------------------------------
+void parserTest() {
+	twk_init(&errorHandler);
+	float value = 1.0f;
+	ds::vec2 v2(0.0f, 0.0f);
+	twk_add("test", "value", &value);
+	twk_add("test", "more", &v2);
+	const char* INPUTS[] = { "", "test", "test {", "test { value", "test { value :", "# comment only", "test { value : 4", "test { value : 5, # trailing" };
+	for (int i = 0; i < 8; ++i) {
+		twk_parse(INPUTS[i]);
+	}
+	if (value != 5.0f) {
+		printf("ERROR - expected 5 but got %g\n", value);
+	}
+	twk_parse("# header\ntest {\n\tvalue : 42 # answer\n\tmore : 10,\n20\n}");
+	if (value != 42.0f || v2.x != 10.0f || v2.y != 20.0f || !twk_verify()) {
+		printf("ERROR - not valid\n");
+	}
+	twk_shutdown();
+}
+
+// -------------------------------------------------------
+// tokenizes the text and stores the tokens - returns count
+// -------------------------------------------------------
+int collectTokens(const char* text, int len, TWKToken* tokens, int max) {
+	int cnt = 0;
+	TWKToken t;
+	const char* p = twk__next_token(text, text, text + len, &t);
+	while (t.type != TWKToken::EMPTY && cnt < max) {
+		tokens[cnt++] = t;
+		p = twk__next_token(text, p, text + len, &t);
+	}
+	return cnt;
+}
+
+#ifdef TWK_SIMD_X86
+// -------------------------------------------------------
+// classifies 16 / 32 bytes starting at p into bit masks
+// -------------------------------------------------------
+void classifySSE2(const char* p, uint32_t* whitespace, uint32_t* name, uint32_t* digit) {
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	*whitespace = twk__whitespace_mask_sse2(v);
+	*name = twk__name_mask_sse2(v);
+	*digit = twk__digit_mask_sse2(v);
+}
+
+TWK_TARGET_AVX2 void classifyAVX2(const char* p, uint32_t* whitespace, uint32_t* name, uint32_t* digit) {
+	__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+	*whitespace = twk__whitespace_mask_avx2(v);
+	*name = twk__name_mask_avx2(v);
+	*digit = twk__digit_mask_avx2(v);
+}
+#endif
+
+// -------------------------------------------------------
+// the vectorized paths must match the scalar path
+// -------------------------------------------------------
+void simdTest() {
+#ifdef TWK_SIMD_X86
+	int detected = _twkSimd;
+	printf("detected simd level: %d\n", detected);
+	// every byte value against PARSE_FLAGS
+	char block[32];
+	for (int c = 0; c < 256; ++c) {
+		memset(block, c, 32);
+		for (int level = TWK_SIMD_SSE2; level <= detected; ++level) {
+			uint32_t ws, nm, dg;
+			if (level == TWK_SIMD_AVX2) {
+				classifyAVX2(block, &ws, &nm, &dg);
+			}
+			else {
+				classifySSE2(block, &ws, &nm, &dg);
+			}
+			if ((ws & 1) != (uint32_t)twk__is_whitespace(c) || (nm & 1) != (uint32_t)twk__is_name(c) || (dg & 1) != (uint32_t)twk__is_digit(c)) {
+				printf("ERROR - level %d classifies %d differently\n", level, c);
+			}
+		}
+	}
+	// token streams of a generated file with odd spacing and comments
+	const int num = 2000;
+	float* values = new float[num];
+	twk_init(&errorHandler);
+	char* text = buildScalingSettings(num, values);
+	int len = (int)strlen(text);
+	for (int i = 0; i < len; i += 7) {
+		if (text[i] == '\t') {
+			text[i] = i % 3 == 0 ? '\n' : ' ';
+		}
+	}
+	TWKToken* expected = new TWKToken[num * 4];
+	TWKToken* actual = new TWKToken[num * 4];
+	for (int level = TWK_SIMD_SSE2; level <= detected; ++level) {
+		// every start offset so the aligned loads see all phases
+		for (int offset = 0; offset < 32; ++offset) {
+			_twkSimd = TWK_SIMD_SCALAR;
+			int ne = collectTokens(text + offset, len - offset, expected, num * 4);
+			_twkSimd = level;
+			int na = collectTokens(text + offset, len - offset, actual, num * 4);
+			bool same = na == ne;
+			for (int i = 0; same && i < na; ++i) {
+				same = actual[i].type == expected[i].type;
+				if (same && actual[i].type == TWKToken::NAME) {
+					same = actual[i].index == expected[i].index && actual[i].size == expected[i].size;
+				}
+				if (same && actual[i].type == TWKToken::NUMBER) {
+					same = actual[i].value == expected[i].value;
+				}
+			}
+			if (!same) {
+				printf("ERROR - level %d offset %d produces different tokens\n", level, offset);
+			}
+		}
+	}
+	_twkSimd = detected;
+	delete[] expected;
+	delete[] actual;
+	delete[] text;
+	delete[] values;
+	twk_shutdown();
+#endif
+}
+
+// -------------------------------------------------------
+// xorshift random numbers for the generated inputs
+// -------------------------------------------------------
+uint32_t nextRandom(uint32_t* state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+// -------------------------------------------------------
+// writes a random decimal number like -123.0045e-12
+// -------------------------------------------------------
+int buildRandomNumber(char* buffer, uint32_t* state) {
+	int l = 0;
+	uint32_t r = nextRandom(state);
+	if (r % 4 == 0) {
+		buffer[l++] = '-';
+	}
+	int intDigits = nextRandom(state) % 13;
+	for (int i = 0; i < intDigits; ++i) {
+		buffer[l++] = '0' + nextRandom(state) % 10;
+	}
+	int fracDigits = nextRandom(state) % 13;
+	if (intDigits == 0 || fracDigits > 0) {
+		buffer[l++] = '.';
+		for (int i = 0; i < fracDigits || i == 0; ++i) {
+			buffer[l++] = '0' + nextRandom(state) % 10;
+		}
+	}
+	if (r % 3 == 0) {
+		l += sprintf(buffer + l, "e%d", (int)(nextRandom(state) % 81) - 40);
+	}
+	buffer[l] = '\0';
+	return l;
+}
+
+// -------------------------------------------------------
+// twk__strtof must match strtof bit for bit. strtof is the
+// reference since strtod followed by a float conversion
+// rounds twice.
+// -------------------------------------------------------
+void floatParsingTest() {
+	const int num = 4000000;
+	char buffer[128];
+	uint32_t state = 0x12345678;
+	int errors = 0;
+	for (int i = 0; i < num; ++i) {
+		int mode = i % 4;
+		if (mode == 0) {
+			buildRandomNumber(buffer, &state);
+		}
+		else {
+			// random float patterns and the values next to the midpoints between neighbours
+			uint32_t bits = nextRandom(&state) & 0x7F7FFFFF;
+			float f;
+			memcpy(&f, &bits, sizeof(f));
+			if (mode == 3) {
+				// without exponent and with few enough digits for the fast path
+				f = (float)(nextRandom(&state) % 100000000) / 1000.0f;
+			}
+			double mid = ((double)f + (double)nextafterf(f, 1e38f)) * 0.5;
+			if (mode == 1) {
+				sprintf(buffer, "%.9g", f);
+			}
+			else if (mode == 2) {
+				sprintf(buffer, "%.40g", mid);
+			}
+			else {
+				sprintf(buffer, "%.17g", mid);
+			}
+		}
+		const char* end = 0;
+		float actual = twk__strtof(buffer, buffer + strlen(buffer), &end);
+		float expected = strtof(buffer, 0);
+		if (memcmp(&actual, &expected, sizeof(float)) != 0 || *end != '\0') {
+			if (++errors < 10) {
+				printf("ERROR - '%s' -> %.9g expected %.9g\n", buffer, actual, expected);
+			}
+		}
+	}
+	printf("float parsing: %d inputs %d errors\n", num, errors);
+	// a literal longer than the fallback buffer that ends the input keeps its exponent
+	char longNumber[200];
+	memset(longNumber, '0', sizeof(longNumber));
+	longNumber[0] = '1';
+	strcpy(longNumber + 150, "e-149");
+	float longValue = twk__strtof(longNumber, longNumber + strlen(longNumber), 0);
+	if (longValue != 1.0f) {
+		printf("ERROR - long literal parsed %g\n", longValue);
+	}
+	// the slow path ignores a locale with a decimal comma
+	const char* LOCALES[] = { "de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "German" };
+	const char* slow = "0.1000000000000000000000000000001";
+	for (int i = 0; i < 4; ++i) {
+		if (setlocale(LC_NUMERIC, LOCALES[i]) != 0) {
+			float value = twk__strtof(slow, slow + strlen(slow), 0);
+			if (value != 0.1f) {
+				printf("ERROR - locale %s parsed %g\n", LOCALES[i], value);
+			}
+			setlocale(LC_NUMERIC, "C");
+			break;
+		}
+	}
+	// throughput on typical settings values
+	const int count = 1000000;
+	char* text = new char[count * 16];
+	char* p = text;
+	for (int i = 0; i < count; ++i) {
+		p += sprintf(p, "%d.%03d ", (int)(nextRandom(&state) % 1000), (int)(nextRandom(&state) % 1000));
+	}
+	const char* end = p;
+	PerfTimer timer;
+	float sum = 0.0f;
+	timer.start();
+	for (const char* c = text; c < end; ) {
+		sum += twk__strtof(c, end, &c);
+		++c;
+	}
+	double fast = timer.stop();
+	timer.start();
+	for (char* c = text; c < end; ) {
+		sum += strtof(c, &c);
+		++c;
+	}
+	double reference = timer.stop();
+	printf("twk__strtof: %.1f MB/s strtof: %.1f MB/s (%g)\n", (end - text) / fast, (end - text) / reference, sum);
+	delete[] text;
+}
+
+void writeTextFile(const char* fileName, const char* text) {
+	FILE* fp = fopen(fileName, "w");
+	if (fp) {
+		fputs(text, fp);
+		fclose(fp);
+	}
+}
+
+// -------------------------------------------------------
+// a burst of writes and a save by rename each trigger
+// exactly one reload
+// -------------------------------------------------------
+void watchTest() {
+	const char* fileName = "watch_test.json";
+	char text[64];
+	writeTextFile(fileName, "test {\n\tvalue : 1\n}\n");
+	twk_init(fileName, &errorHandler);
+	float value = 0.0f;
+	twk_add("test", "value", &value);
+	twk_load();
+	if (twk_load()) {
+		printf("ERROR - reloaded unchanged file\n");
+	}
+	for (int i = 2; i <= 5; ++i) {
+		sprintf(text, "test {\n\tvalue : %d\n}\n", i);
+		writeTextFile(fileName, text);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	int reloads = 0;
+	for (int i = 0; i < 10; ++i) {
+		reloads += twk_load() ? 1 : 0;
+	}
+	if (reloads != 1 || value != 5.0f) {
+		printf("ERROR - burst: %d reloads value %g\n", reloads, value);
+	}
+	// editors writing a temp file and renaming it
+	writeTextFile("watch_test.tmp", "test {\n\tvalue : 42\n}\n");
+	remove(fileName);
+	rename("watch_test.tmp", fileName);
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	reloads = 0;
+	for (int i = 0; i < 10; ++i) {
+		reloads += twk_load() ? 1 : 0;
+	}
+	if (reloads != 1 || value != 42.0f) {
+		printf("ERROR - rename: %d reloads value %g\n", reloads, value);
+	}
+	twk_shutdown();
+	remove(fileName);
+}
+
+// -------------------------------------------------------
+// waits until the background thread has a pending reload
+// and returns the time spent in twk_apply_pending
+// -------------------------------------------------------
+double waitAndApply() {
+	PerfTimer timer;
+	for (int i = 0; i < 500; ++i) {
+		timer.start();
+		if (twk_apply_pending()) {
+			return timer.stop();
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	printf("ERROR - nothing applied\n");
+	return 0.0;
+}
+
+// -------------------------------------------------------
+// compares the frame cost of a synchronous reload with
+// applying a reload staged by the background thread
+// -------------------------------------------------------
+void backgroundReloadTest() {
+	const char* fileName = "background_test.json";
+	const int num = 100000;
+	float* values = new float[num];
+	twk_init(fileName, &errorHandler);
+	char* text = buildScalingSettings(num, values);
+	writeTextFile(fileName, text);
+	PerfTimer timer;
+	timer.start();
+	twk_load();
+	double sync = timer.stop();
+	values[num - 1] = 0.0f;
+	twk_start_background_reload();
+	// the first pass loads the file even though it did not change
+	double apply = waitAndApply();
+	if (values[num - 1] != (num - 1) + 0.5f) {
+		printf("ERROR - value not applied\n");
+	}
+	printf("items: %d twk_load: %.1f microseconds twk_apply_pending: %.1f microseconds\n", num, sync, apply);
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	char* last = strrchr(text, ':');
+	strcpy(last, ": 1.25\n}\n");
+	writeTextFile(fileName, text);
+	waitAndApply();
+	if (values[num - 1] != 1.25f || !twk_verify()) {
+		printf("ERROR - change not applied\n");
+	}
+	twk_shutdown();
+	remove(fileName);
+	delete[] text;
+	delete[] values;
+}
+
+// -------------------------------------------------------
+// values of an included file are overridden by everything
+// after the directive and editing the included file
+// triggers a reload
+// -------------------------------------------------------
+void includeTest() {
+	const char* fileName = "include_test.txt";
+	writeTextFile("include_base.txt", "test {\n\tspeed : 1\n\tsize : 2\n}\n");
+	writeTextFile(fileName, "@include \"include_base.txt\"\ntest {\n\tsize : 3\n}\n");
+	twk_init(fileName, &errorHandler);
+	float speed = 0.0f;
+	float size = 0.0f;
+	twk_add("test", "speed", &speed);
+	twk_add("test", "size", &size);
+	twk_load();
+	if (speed != 1.0f || size != 3.0f || !twk_verify()) {
+		printf("ERROR - include: speed %g size %g\n", speed, size);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	writeTextFile("include_base.txt", "test {\n\tspeed : 4\n\tsize : 2\n}\n");
+	bool reloaded = false;
+	for (int i = 0; i < 100 && !reloaded; ++i) {
+		reloaded = twk_load();
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	if (!reloaded || speed != 4.0f || size != 3.0f) {
+		printf("ERROR - include not reloaded: speed %g size %g\n", speed, size);
+	}
+	twk_shutdown();
+	remove(fileName);
+	remove("include_base.txt");
+}
+
+// -------------------------------------------------------
+// splits a large settings text into files at category
+// boundaries and compares twk_load_many with parsing the
+// whole text - later files override earlier ones
+// -------------------------------------------------------
+void loadManyTest() {
+	const int num = 100000;
+	const int count = 8;
+	float* values = new float[num];
+	twk_init(&errorHandler);
+	char* text = buildScalingSettings(num, values);
+	PerfTimer timer;
+	timer.start();
+	twk_parse(text);
+	double single = timer.stop();
+	char fileNames[count + 1][32];
+	const char* files[count + 1];
+	size_t length = strlen(text);
+	char* start = text;
+	for (int i = 0; i < count; ++i) {
+		char* end = text + length;
+		if (i < count - 1) {
+			end = strstr(text + length * (i + 1) / count, "}\n") + 2;
+		}
+		char c = *end;
+		*end = '\0';
+		sprintf(fileNames[i], "load_many_%d.txt", i);
+		writeTextFile(fileNames[i], start);
+		files[i] = fileNames[i];
+		*end = c;
+		start = end;
+	}
+	sprintf(fileNames[count], "load_many_override.txt");
+	writeTextFile(fileNames[count], "cat_a {\n\tvalue_a : 7\n}\n");
+	files[count] = fileNames[count];
+	twk_shutdown();
+	twk_init(&errorHandler);
+	delete[] buildScalingSettings(num, values);
+	memset(values, 0, num * sizeof(float));
+	timer.start();
+	twk_load_many(files, count + 1);
+	double many = timer.stop();
+	if (values[0] != 7.0f || values[num - 1] != (num - 1) + 0.5f || !twk_verify()) {
+		printf("ERROR - load many: %g %g\n", values[0], values[num - 1]);
+	}
+	// the override file first
+	files[count] = fileNames[0];
+	files[0] = fileNames[count];
+	twk_load_many(files, count + 1);
+	if (values[0] != 0.5f) {
+		printf("ERROR - load many order: %g\n", values[0]);
+	}
+	// a hot reload only parses the changed file and applies the others again
+	const char* changed = "cat_a {\n\tvalue_a : 7\n}\ncat_extra {\n\tvalue : 3\n}\n";
+	writeTextFile(fileNames[count], changed);
+	for (int j = 0; j < 100 && !twk_load(); ++j) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	float extra = 0.0f;
+	if (!twk_get("cat_extra", "value", &extra) || extra != 3.0f || values[0] != 0.5f || values[num - 1] != (num - 1) + 0.5f || twk_stats().last.bytesRead != strlen(changed)) {
+		printf("ERROR - load many reload: %g %g %d\n", extra, values[num - 1], (int)twk_stats().last.bytesRead);
+	}
+	printf("items: %d files: %d twk_parse: %.1f twk_load_many: %.1f microseconds\n", num, count, single, many);
+	twk_shutdown();
+	for (int i = 0; i <= count; ++i) {
+		remove(fileNames[i]);
+	}
+	delete[] text;
+	delete[] values;
+}
+
+// -------------------------------------------------------
+// item store benchmark at 100k items - registration, full
+// and unchanged parse, found sweeps and lookups
+// -------------------------------------------------------
+void itemStoreTest() {
+	const int num = 100000;
+	float* values = new float[num];
+	twk_init(&errorHandler);
+	PerfTimer timer;
+	timer.start();
+	char* text = buildScalingSettings(num, values);
+	double add = timer.stop();
+	timer.start();
+	twk_parse(text);
+	double full = timer.stop();
+	timer.start();
+	twk_parse(text);
+	double unchanged = timer.stop();
+	timer.start();
+	int valid = 0;
+	for (int i = 0; i < 100; ++i) {
+		valid += twk_verify() ? 1 : 0;
+	}
+	double verify = timer.stop() / 100.0;
+	Tweakable* list = new Tweakable[128];
+	timer.start();
+	int found = 0;
+	for (int i = 0; i < 100; ++i) {
+		found += twk_get_tweakables(i * 10, list, 128);
+	}
+	double category = timer.stop() / 100.0;
+	char name[32];
+	char categoryName[32];
+	float sum = 0.0f;
+	timer.start();
+	for (int i = 0; i < num; ++i) {
+		buildName(categoryName, "cat_", i / 100);
+		buildName(name, "value_", i % 100);
+		float v = 0.0f;
+		twk_get(categoryName, name, &v);
+		sum += v;
+	}
+	double get = timer.stop();
+	if (valid != 100 || found != 100 * 100 || sum == 0.0f) {
+		printf("ERROR - item store\n");
+	}
+	printf("items: %d add: %.1f parse: %.1f unchanged: %.1f verify: %.1f category list: %.1f get all: %.1f microseconds\n", num, add, full, unchanged, verify, category, get);
+	twk_shutdown();
+	delete[] list;
+	delete[] text;
+	delete[] values;
+	// "costarring" and "liquid" share the same FNV-1a hash
+	TWKContext* ctx = twk_create(&errorHandler);
+	float a = 0.0f;
+	float b = 0.0f;
+	twk_add(ctx, "collide", "costarring", &a);
+	twk_add(ctx, "collide", "liquid", &b);
+	twk_parse(ctx, "collide {\n\tliquid : 2\n\tcostarring : 1\n}\n");
+	float ga = 0.0f;
+	float gb = 0.0f;
+	if (a != 1.0f || b != 2.0f || !twk_verify(ctx) || !twk_get(ctx, "collide", "costarring", &ga) || !twk_get(ctx, TWK_KEY("collide", "liquid"), &gb) || ga != 1.0f || gb != 2.0f) {
+		printf("ERROR - colliding items: %g %g %g %g\n", a, b, ga, gb);
+	}
+	twk_destroy(ctx);
+}
+
+// -------------------------------------------------------
+// bulk registration of struct instances
+// -------------------------------------------------------
+struct SparkleSettings {
+	float gap;
+	float ttl;
+	float startScale;
+	float endScale;
+	float velocity;
+	ds::vec2 size;
+	int count;
+	float weights[4];
+};
+
+static const TwkField SPARKLE_FIELDS[] = {
+	TWK_FIELD(SparkleSettings, gap, "gap"),
+	TWK_FIELD(SparkleSettings, ttl, "ttl"),
+	TWK_FIELD(SparkleSettings, startScale, "start_scale"),
+	TWK_FIELD(SparkleSettings, endScale, "end_scale"),
+	TWK_FIELD(SparkleSettings, velocity, "velocity"),
+	TWK_FIELD(SparkleSettings, size, "size"),
+	TWK_FIELD(SparkleSettings, count, "count"),
+	TWK_FIELD(SparkleSettings, weights, "weights")
+};
+
+void structTest() {
+	const int num = 10000;
+	const int numFields = sizeof(SPARKLE_FIELDS) / sizeof(SPARKLE_FIELDS[0]);
+	if (SPARKLE_FIELDS[5].type != ST_VEC2 || SPARKLE_FIELDS[6].type != ST_INT || SPARKLE_FIELDS[7].type != ST_ARRAY || SPARKLE_FIELDS[7].arrayLength != 4) {
+		printf("ERROR - field types\n");
+	}
+	SparkleSettings* settings = new SparkleSettings[num];
+	char* names = new char[num * 32];
+	const char** categories = new const char*[num];
+	for (int i = 0; i < num; ++i) {
+		buildName(names + i * 32, "sparkle_", i);
+		categories[i] = names + i * 32;
+	}
+	// one call per field
+	twk_init(&errorHandler);
+	PerfTimer timer;
+	timer.start();
+	for (int i = 0; i < num; ++i) {
+		SparkleSettings& s = settings[i];
+		twk_add(categories[i], "gap", &s.gap);
+		twk_add(categories[i], "ttl", &s.ttl);
+		twk_add(categories[i], "start_scale", &s.startScale);
+		twk_add(categories[i], "end_scale", &s.endScale);
+		twk_add(categories[i], "velocity", &s.velocity);
+		twk_add(categories[i], "size", &s.size);
+		twk_add(categories[i], "count", &s.count);
+		twk_add(categories[i], "weights", s.weights, 4);
+	}
+	double single = timer.stop();
+	twk_shutdown();
+	// one call for all instances
+	twk_init(&errorHandler);
+	timer.start();
+	twk_add_struct(categories, num, settings, sizeof(SparkleSettings), SPARKLE_FIELDS, numFields);
+	double bulk = timer.stop();
+	const char* format = "%s {\n\tgap : %d\n\tttl : 0.5\n\tstart_scale : 1\n\tend_scale : 0.25\n\tvelocity : 80\n\tsize : 4, 8\n\tcount : 3\n\tweights : 1, 2, 3, 4\n}\n";
+	std::string text;
+	char line[256];
+	for (int i = 0; i < num; ++i) {
+		sprintf(line, format, categories[i], i);
+		text += line;
+	}
+	twk_parse(text.c_str());
+	const SparkleSettings& last = settings[num - 1];
+	if (!twk_verify() || last.gap != (float)(num - 1) || last.size.y != 8.0f || last.count != 3 || last.weights[3] != 4.0f) {
+		printf("ERROR - struct values not applied\n");
+	}
+	printf("instances: %d fields: %d twk_add: %.1f twk_add_struct: %.1f microseconds\n", num, numFields, single, bulk);
+	twk_shutdown();
+	// the fields are found through the struct block, a field added again
+	// keeps the first item and is never found, new names are indexed
+	TWKContext* ctx = twk_create(&errorHandler);
+	SparkleSettings pair[2];
+	const char* pairNames[2] = { "pair_a", "pair_b" };
+	twk_add_struct(ctx, pairNames, 2, pair, sizeof(SparkleSettings), SPARKLE_FIELDS, numFields);
+	float other = 0.0f;
+	float extra = 0.0f;
+	twk_add(ctx, "pair_b", "gap", &other);
+	twk_add(ctx, "pair_b", "extra", &extra);
+	std::string pairText;
+	for (int i = 0; i < 2; ++i) {
+		sprintf(line, format, pairNames[i], i + 1);
+		pairText += line;
+	}
+	pairText += "pair_b {\n\textra : 3\n\ttotal : gap + extra\n}\n";
+	twk_parse(ctx, pairText.c_str());
+	float gap = 0.0f;
+	float total = 0.0f;
+	ds::vec2 size(0, 0);
+	if (pair[1].gap != 2.0f || other != 0.0f || extra != 3.0f || !twk_get(ctx, "pair_a", "gap", &gap) || gap != 1.0f
+		|| !twk_get(ctx, TWK_KEY("pair_b", "size"), &size) || size.y != 8.0f || !twk_get(ctx, "pair_b", "total", &total) || total != 5.0f) {
+		printf("ERROR - struct block lookups: %g %g %g %g %g\n", pair[1].gap, other, extra, gap, total);
+	}
+	twk_destroy(ctx);
+	delete[] categories;
+	delete[] names;
+	delete[] settings;
+}
+
+// -------------------------------------------------------
+// string arena - colliding names stay apart and name
+// pointers survive adding many more items
+// -------------------------------------------------------
+void stringArenaTest() {
+	// "costarring" and "liquid" share the same FNV-1a hash
+	twk_init();
+	float a = 0.0f;
+	float b = 0.0f;
+	twk_add("costarring", "value", &a);
+	twk_add("other", "liquid", &b);
+	Tweakable list[4];
+	twk_get_tweakables("other", list, 4);
+	const char* name = list[0].name;
+	const char* category = twk_get_category_name(0);
+	if (strcmp(name, "liquid") != 0 || strcmp(category, "costarring") != 0) {
+		printf("ERROR - hash collision: '%s' '%s'\n", category, name);
+	}
+	const int num = 100000;
+	float* values = new float[num];
+	char itemName[32];
+	PerfTimer timer;
+	timer.start();
+	for (int i = 0; i < num; ++i) {
+		buildName(itemName, "unique_value_name_", i);
+		twk_add("arena", itemName, &values[i]);
+	}
+	double add = timer.stop();
+	if (strcmp(name, "liquid") != 0 || twk_get_category_name(0) != category) {
+		printf("ERROR - name pointer moved\n");
+	}
+	printf("interned: %d names in %.1f microseconds\n", num, add);
+	twk_shutdown();
+	delete[] values;
+	// categories with the same hash are kept apart as well
+	TWKContext* ctx = twk_create(&errorHandler);
+	float c = 0.0f;
+	float d = 0.0f;
+	twk_add(ctx, "costarring", "value", &c);
+	twk_add(ctx, "liquid", "value", &d);
+	twk_parse(ctx, "costarring {\n\tvalue : 1\n}\nliquid {\n\tvalue : 2\n}\n");
+	if (twk_num_categories(ctx) != 2 || c != 1.0f || d != 2.0f) {
+		printf("ERROR - colliding categories: %d %g %g\n", twk_num_categories(ctx), c, d);
+	}
+	twk_destroy(ctx);
+}
+
+// -------------------------------------------------------
+// typed handles survive reloads and need no string work
+// -------------------------------------------------------
+void handleTest() {
+	// the padding items below are never found in the text
+	twk_init();
+	float gap = 0.0f;
+	TwkHandle<float> gapHandle = twk_add("sparkle", "gap", &gap);
+	ds::vec3 dir(0, 0, 0);
+	TwkHandle<ds::vec3> dirHandle = twk_add(TWK_KEY("sparkle", "dir"), &dir);
+	float ar[4] = { 0 };
+	TwkHandle<float*> arHandle = twk_add("sparkle", "ar", ar, 4);
+	twk_parse("sparkle {\n\tgap : 2.5\n\tdir : 1, 2, 3\n\tar : 1, 2, 3, 4\n}\n");
+	float value = 0.0f;
+	ds::vec3 v(0, 0, 0);
+	float values[4] = { 0 };
+	if (!twk_get(gapHandle, &value) || value != 2.5f || !twk_get(dirHandle, &v) || v.z != 3.0f || !twk_get(arHandle, values, 4) || values[3] != 4.0f) {
+		printf("ERROR - get by handle\n");
+	}
+	twk_set(gapHandle, 5.0f);
+	twk_set(dirHandle, ds::vec3(4, 5, 6));
+	if (gap != 5.0f || dir.x != 4.0f) {
+		printf("ERROR - set by handle\n");
+	}
+	// handles stay valid when items are added and the file is reloaded
+	for (int i = 0; i < 1000; ++i) {
+		char name[32];
+		buildName(name, "value_", i);
+		twk_add("more", name, &values[0]);
+	}
+	twk_parse("sparkle {\n\tgap : 7.5\n\tdir : 1, 2, 3\n\tar : 1, 2, 3, 4\n}\n");
+	if (!twk_get(gapHandle, &value) || value != 7.5f) {
+		printf("ERROR - handle after reload\n");
+	}
+	const int num = 1000000;
+	PerfTimer timer;
+	timer.start();
+	float sum = 0.0f;
+	for (int i = 0; i < num; ++i) {
+		twk_get(gapHandle, &value);
+		sum += value;
+	}
+	double byHandle = timer.stop();
+	printf("%d gets by handle: %.1f microseconds (%g)\n", num, byHandle, sum);
+	twk_shutdown();
+}
+
+// -------------------------------------------------------
+// compile time hashed keys
+// -------------------------------------------------------
+static_assert(twk_fnv1a_const("sparkle") == 0x2B1CD835, "compile time hash of sparkle");
+static_assert(twk_fnv1a_const("gap") == 0x481721CF, "compile time hash of gap");
+
+void keyTest() {
+	const TwkKey key = TWK_KEY("sparkle", "gap");
+	if (key.categoryHash != twk_fnv1a("sparkle") || key.nameHash != twk_fnv1a("gap")) {
+		printf("ERROR - compile time hash does not match twk_fnv1a\n");
+	}
+	twk_init(&errorHandler);
+	float gap = 0.0f;
+	twk_add(key, &gap);
+	ds::vec2 size(0, 0);
+	twk_add(TWK_KEY("sparkle", "size"), &size);
+	twk_parse("sparkle {\n\tgap : 2.5\n\tsize : 4, 8\n}\n");
+	float value = 0.0f;
+	ds::vec2 v(0, 0);
+	if (!twk_get(key, &value) || value != 2.5f || !twk_get("sparkle", "size", &v) || v.y != 8.0f || twk_get(key, &v)) {
+		printf("ERROR - get by key\n");
+	}
+	const int num = 1000000;
+	PerfTimer timer;
+	timer.start();
+	float sum = 0.0f;
+	for (int i = 0; i < num; ++i) {
+		twk_get("sparkle", "gap", &value);
+		sum += value;
+	}
+	double byName = timer.stop();
+	timer.start();
+	for (int i = 0; i < num; ++i) {
+		twk_get(TWK_KEY("sparkle", "gap"), &value);
+		sum += value;
+	}
+	double byKey = timer.stop();
+	printf("%d gets by name: %.1f by key: %.1f microseconds (%g)\n", num, byName, byKey, sum);
+	twk_shutdown();
+}
+
+// -------------------------------------------------------
+// values without a registered item are read from the pool
+// -------------------------------------------------------
+void poolTest() {
+	twk_init(&errorHandler);
+	float registered = 0.0f;
+	twk_add("pool", "registered", &registered);
+	twk_parse("pool {\n\tregistered : 1\n\tf : 2.5\n\ti : -3\n\tu : 7\n\tv : 1, 2\n\tc : 255, 0, 51, 255\n\tar : 1, 2, 3, 4, 5\n}\n");
+	float f = 0.0f;
+	int i = 0;
+	uint32_t u = 0;
+	ds::vec2 v(0, 0);
+	ds::vec3 v3(0, 0, 0);
+	ds::Color c(0.0f, 0.0f, 0.0f, 0.0f);
+	float ar[8] = { 0 };
+	if (!twk_get("pool", "f", &f) || f != 2.5f || !twk_get("pool", "i", &i) || i != -3 || !twk_get(TWK_KEY("pool", "u"), &u) || u != 7
+		|| !twk_get("pool", "v", &v) || v.y != 2.0f || !twk_get("pool", "c", &c) || c.r != 1.0f || c.b != 0.2f
+		|| !twk_get("pool", "ar", ar, 8) || ar[4] != 5.0f || ar[5] != 0.0f || !twk_get("pool", "registered", &f) || f != 1.0f) {
+		printf("ERROR - pool values\n");
+	}
+	if (twk_get("pool", "v", &v3) || twk_get("pool", "missing", &f) || twk_get("other", "f", &f)) {
+		printf("ERROR - pool accepted invalid get\n");
+	}
+	// the unchanged block is skipped and keeps the values, removed keys are gone
+	twk_parse("pool {\n\tregistered : 1\n\tf : 2.5\n\ti : -3\n\tu : 7\n\tv : 1, 2\n\tc : 255, 0, 51, 255\n\tar : 1, 2, 3, 4, 5\n}\n");
+	if (!twk_get("pool", "f", &f) || f != 2.5f) {
+		printf("ERROR - pool value lost on unchanged parse\n");
+	}
+	twk_parse("pool {\n\tf : 4, 5, 6\n}\n");
+	if (twk_get("pool", "f", &f) || !twk_get("pool", "f", &v3) || v3.z != 6.0f || twk_get("pool", "i", &i)) {
+		printf("ERROR - pool reload\n");
+	}
+	// baked binaries fill the pool as well
+	size_t size = 0;
+	char* data = twk_bake_binary("pool {\n\tregistered : 3\n\tbaked : 9\n}\n", &size);
+	twk_load_binary(data, size);
+	if (!twk_get("pool", "baked", &f) || f != 9.0f || registered != 3.0f || twk_get("pool", "f", &v3)) {
+		printf("ERROR - pool binary\n");
+	}
+	delete[] data;
+	twk_shutdown();
+	// staged reloads
+	TWKContext* ctx = twk_create(&errorHandler);
+	twk_add(ctx, "pool", "registered", &registered);
+	writeTextFile("pool_a.txt", "pool {\n\tregistered : 5, 6\n\tstaged : 11\n}\n");
+	const char* files[] = { "pool_a.txt" };
+	twk_load_many(ctx, files, 1);
+	if (!twk_get(ctx, "pool", "staged", &f) || f != 11.0f || twk_get(ctx, "pool", "registered", &v) || registered != 3.0f) {
+		printf("ERROR - pool staged\n");
+	}
+	twk_destroy(ctx);
+	remove("pool_a.txt");
+}
+
+// -------------------------------------------------------
+// curves are baked on load and the batch evaluation matches
+// the single one exactly
+// -------------------------------------------------------
+void curveTest() {
+	twk_init(&errorHandler);
+	TwkCurve scale;
+	const float defaults[] = { 0.0f, 1.0f, 1.0f, 1.0f };
+	TwkHandle<TwkCurve> handle = twk_add("particle", "scale", &scale, TWK_CURVE_LINEAR, defaults, 4);
+	TwkCurve fade;
+	twk_add("particle", "fade", &fade, TWK_CURVE_HERMITE);
+	if (twk_curve_eval(scale, 0.5f) != 1.0f || twk_curve_eval(fade, 0.5f) != 0.0f) {
+		printf("ERROR - curve defaults\n");
+	}
+	twk_parse("particle {\n\tscale : 0, 0, 0.5, 2, 1, 1\n\t# smoothstep\n\tfade : 0, 0, 0, 1, 1, 0\n}\n");
+	const float tolerance = 2.0f / TWK_CURVE_RESOLUTION;
+	if (twk_curve_eval(scale, 0.0f) != 0.0f || twk_curve_eval(scale, 1.0f) != 1.0f || twk_curve_eval(scale, -5.0f) != 0.0f || twk_curve_eval(scale, 5.0f) != 1.0f
+		|| fabs(twk_curve_eval(scale, 0.25f) - 1.0f) > tolerance || fabs(twk_curve_eval(scale, 0.75f) - 1.5f) > tolerance) {
+		printf("ERROR - linear curve: %g %g\n", twk_curve_eval(scale, 0.25f), twk_curve_eval(scale, 0.75f));
+	}
+	if (fabs(twk_curve_eval(fade, 0.5f) - 0.5f) > 0.001f || fabs(twk_curve_eval(fade, 0.25f) - 0.15625f) > 0.001f) {
+		printf("ERROR - hermite curve: %g %g\n", twk_curve_eval(fade, 0.5f), twk_curve_eval(fade, 0.25f));
+	}
+	const int num = 1000003;
+	float* t = new float[num];
+	float* batch = new float[num];
+	for (int i = 0; i < num; ++i) {
+		t[i] = -0.1f + 1.2f * static_cast<float>(rand()) / RAND_MAX;
+	}
+	t[0] = NAN;
+	t[1] = INFINITY;
+	t[2] = -INFINITY;
+	PerfTimer timer;
+	timer.start();
+	twk_curve_eval(fade, t, batch, num);
+	double batched = timer.stop();
+	float sum = 0.0f;
+	int mismatches = 0;
+	timer.start();
+	for (int i = 0; i < num; ++i) {
+		float v = twk_curve_eval(fade, t[i]);
+		sum += v;
+		mismatches += v != batch[i];
+	}
+	double single = timer.stop();
+	if (mismatches != 0) {
+		printf("ERROR - %d batch results differ\n", mismatches);
+	}
+	// unsorted keys are rejected and the curve keeps its keys
+	twk_parse("particle {\n\tscale : 1, 0, 0, 2\n\tfade : 0, 0, 0, 1, 1, 0\n}\n");
+	if (fabs(twk_curve_eval(scale, 0.5f) - 2.0f) > tolerance || scale.count != 6) {
+		printf("ERROR - invalid curve applied\n");
+	}
+	const float keys[] = { 0.0f, 4.0f, 2.0f, 8.0f };
+	twk_set(handle, keys, 4);
+	TwkCurve copy;
+	if (!twk_get(handle, &copy) || twk_curve_eval(copy, 1.0f) != 6.0f) {
+		printf("ERROR - curve set: %g\n", twk_curve_eval(copy, 1.0f));
+	}
+	// only the keys are saved
+	twk_save("curve_test.txt");
+	char buffer[256];
+	memset(buffer, 0, sizeof(buffer));
+	FILE* fp = fopen("curve_test.txt", "r");
+	if (fp) {
+		fread(buffer, 1, sizeof(buffer) - 1, fp);
+		fclose(fp);
+	}
+	if (strstr(buffer, "scale : 0, 4, 2, 8\n") == 0 || strstr(buffer, "fade : 0, 0, 0, 1, 1, 0\n") == 0) {
+		printf("ERROR - curve save:\n%s\n", buffer);
+	}
+	remove("curve_test.txt");
+	printf("curve evaluations: %d batch: %.1f single: %.1f microseconds (%g)\n", num, batched, single, sum);
+	delete[] t;
+	delete[] batch;
+	twk_shutdown();
+}
+
+// -------------------------------------------------------
+// derived values follow their inputs and are only evaluated
+// again if one of the inputs changed
+// -------------------------------------------------------
+static int derivedErrors = 0;
+
+void derivedErrorHandler(const char*) {
+	++derivedErrors;
+}
+
+void derivedTest() {
+	twk_init(&derivedErrorHandler);
+	int count = 0;
+	float ttl = 0.0f;
+	float rate = 0.0f;
+	float radius = 0.0f;
+	int half = 0;
+	ds::vec2 size(0, 0);
+	twk_add("emitter", "count", &count);
+	twk_add("emitter", "ttl", &ttl);
+	twk_add("emitter", "spawn_rate", &rate);
+	twk_add("emitter", "radius", &radius);
+	twk_add("emitter", "half", &half);
+	twk_add("emitter", "size", &size);
+	const char* text = "global {\n\tscale : 2\n}\nemitter {\n\tcount : 100\n\tttl : 4\n\tspawn_rate : count / ttl\n\tradius : (base + 1.5) * global.scale\n\tbase : 0.5\n\thalf : -radius / 2 + 3.9\n\tsize : radius * 2, radius / 4 # comment\n\tpooled : spawn_rate - 5\n}\n";
+	twk_parse(text);
+	float pooled = 0.0f;
+	if (rate != 25.0f || radius != 4.0f || half != 1 || size.x != 8.0f || size.y != 1.0f || !twk_get("emitter", "pooled", &pooled) || pooled != 20.0f) {
+		printf("ERROR - derived values %g %g %d %g %g %g\n", rate, radius, half, size.x, size.y, pooled);
+	}
+	if (twk_stats().last.derivedEvaluated != 5 || derivedErrors != 0) {
+		printf("ERROR - derived evaluations %d errors %d\n", twk_stats().last.derivedEvaluated, derivedErrors);
+	}
+	// only the expressions that read the changed scale are evaluated again
+	twk_parse("global {\n\tscale : 4\n}\nemitter {\n\tcount : 100\n\tttl : 4\n\tspawn_rate : count / ttl\n\tradius : (base + 1.5) * global.scale\n\tbase : 0.5\n\thalf : -radius / 2 + 3.9\n\tsize : radius * 2, radius / 4 # comment\n\tpooled : spawn_rate - 5\n}\n");
+	if (radius != 8.0f || half != -0 || size.x != 16.0f || rate != 25.0f || twk_stats().last.derivedEvaluated != 3) {
+		printf("ERROR - derived incremental %g %d %g evaluations %d\n", radius, half, size.x, twk_stats().last.derivedEvaluated);
+	}
+	// a later constant replaces the expression and a code default can be an input
+	ttl = 0.0f;
+	twk_parse("emitter {\n\tcount : 10\n\tspawn_rate : count / ttl\n\tspawn_rate : 7\n\tradius : ttl + count\n}\n");
+	if (rate != 7.0f || radius != 10.0f) {
+		printf("ERROR - derived override %g %g\n", rate, radius);
+	}
+	// cycles, unknown references and invalid expressions are reported
+	derivedErrors = 0;
+	twk_parse("emitter {\n\tcount : 10\n\tttl : 2\n\tspawn_rate : radius * 2\n\tradius : spawn_rate + 1\n\thalf : unknown * 2\n\tsize : count * , 2\n}\n");
+	if (derivedErrors < 4) {
+		printf("ERROR - derived errors %d\n", derivedErrors);
+	}
+	// staged reloads and baked binaries evaluate the same way
+	twk_shutdown();
+	TWKContext* ctx = twk_create(&derivedErrorHandler);
+	twk_add(ctx, "emitter", "spawn_rate", &rate);
+	writeTextFile("derived_a.txt", "emitter {\n\tcount : 100\n\tspawn_rate : count / ttl\n}\n");
+	writeTextFile("derived_b.txt", "emitter {\n\tttl : 5\n}\n");
+	const char* files[] = { "derived_a.txt", "derived_b.txt" };
+	twk_load_many(ctx, files, 2);
+	if (rate != 20.0f) {
+		printf("ERROR - derived staged %g\n", rate);
+	}
+	twk_destroy(ctx);
+	// a sign in front of whitespace is an operator and a single line block ends the expression at the next key
+	derivedErrors = 0;
+	ctx = twk_create(&derivedErrorHandler);
+	float a = 0.0f;
+	float b = 0.0f;
+	twk_add(ctx, "sum", "a", &a);
+	twk_add(ctx, "sum", "b", &b);
+	twk_add(ctx, "sum", "size", &size);
+	twk_parse(ctx, "sum {\n\ta : 3 - 1\n\tb : 4 + 1\n\tsize : 3, -1\n}\n");
+	if (a != 2.0f || b != 5.0f || size.y != -1.0f || derivedErrors != 0) {
+		printf("ERROR - derived sum %g %g %g errors %d\n", a, b, size.y, derivedErrors);
+	}
+	twk_parse(ctx, "sum { a : 6 - 3  b : (1 + 1) * 3  size : 4 -1 }");
+	if (a != 3.0f || b != 6.0f || size.x != 4.0f || size.y != -1.0f || derivedErrors != 0) {
+		printf("ERROR - derived single line %g %g %g errors %d\n", a, b, size.x, derivedErrors);
+	}
+	// names that only differ after 127 characters are different keys
+	std::string longName(130, 'k');
+	std::string longText = "sum {\n\t" + longName + "x : 1\n\t" + longName + "y : 2\n\ta : " + longName + "x + " + longName + "y * 10\n\tb : 1\n\tsize : 1, 1\n}\n";
+	twk_parse(ctx, longText.c_str());
+	if (a != 21.0f || derivedErrors != 0) {
+		printf("ERROR - derived long names %g errors %d\n", a, derivedErrors);
+	}
+	twk_destroy(ctx);
+	remove("derived_a.txt");
+	remove("derived_b.txt");
+	size_t bytes = 0;
+	char* data = twk_bake_binary(text, &bytes);
+	twk_init(&derivedErrorHandler);
+	twk_add("emitter", "spawn_rate", &rate);
+	twk_add("emitter", "size", &size);
+	rate = 0.0f;
+	twk_load_binary(data, bytes);
+	if (rate != 25.0f || size.x != 8.0f || !twk_get("emitter", "pooled", &pooled) || pooled != 20.0f) {
+		printf("ERROR - derived binary %g %g\n", rate, size.x);
+	}
+	delete[] data;
+	twk_shutdown();
+}
+
+// -------------------------------------------------------
+// callbacks only fire for values that actually changed
+// -------------------------------------------------------
+struct CallbackCounter {
+	int calls;
+	char last[64];
+};
+
+void countChange(const char* category, const char* name, void* user) {
+	CallbackCounter* counter = static_cast<CallbackCounter*>(user);
+	++counter->calls;
+	sprintf(counter->last, "%s.%s", category, name != 0 ? name : "*");
+}
+
+void callbackTest() {
+	twk_init(&errorHandler);
+	float speed = 0.0f;
+	TwkHandle<float> speedHandle = twk_add("player", "speed", &speed);
+	ds::vec2 size(0, 0);
+	twk_add("player", "size", &size);
+	int count = 0;
+	twk_add("particles", "count", &count);
+	CallbackCounter speedCounter = { 0, "" };
+	CallbackCounter playerCounter = { 0, "" };
+	CallbackCounter particlesCounter = { 0, "" };
+	twk_on_change("player", "speed", countChange, &speedCounter);
+	twk_on_change("player", countChange, &playerCounter);
+	twk_on_change("particles", countChange, &particlesCounter);
+	twk_parse("player {\n\tspeed : 4\n\tsize : 2, 2\n}\nparticles {\n\tcount : 10\n}\n");
+	// one call per category even if several items changed
+	if (speedCounter.calls != 1 || playerCounter.calls != 1 || particlesCounter.calls != 1) {
+		printf("ERROR - initial load %d %d %d\n", speedCounter.calls, playerCounter.calls, particlesCounter.calls);
+	}
+	twk_parse("player {\n\tspeed : 4\n\tsize : 3, 2\n}\nparticles {\n\tcount : 10.4\n}\n");
+	// speed is unchanged and count is still 10 after the conversion
+	if (speedCounter.calls != 1 || playerCounter.calls != 2 || particlesCounter.calls != 1) {
+		printf("ERROR - reload %d %d %d\n", speedCounter.calls, playerCounter.calls, particlesCounter.calls);
+	}
+	printf("last change: %s\n", playerCounter.last);
+	// writes through a handle notify as well and are listed once
+	twk_set(speedHandle, 6.0f);
+	twk_set(speedHandle, 6.0f);
+	twk_set(speedHandle, 7.0f);
+	Tweakable changed[4];
+	int numChanged = twk_get_changed_tweakables(changed, 4);
+	if (speedCounter.calls != 3 || playerCounter.calls != 4 || particlesCounter.calls != 1 || numChanged != 2 || changed[1].ptr.fPtr != &speed) {
+		printf("ERROR - handle %d %d %d changed: %d\n", speedCounter.calls, playerCounter.calls, particlesCounter.calls, numChanged);
+	}
+	// the unchanged text restores the value of the file
+	twk_parse("player {\n\tspeed : 4\n\tsize : 3, 2\n}\nparticles {\n\tcount : 10.4\n}\n");
+	if (speed != 4.0f || speedCounter.calls != 4 || playerCounter.calls != 5) {
+		printf("ERROR - handle reload %g %d %d\n", speed, speedCounter.calls, playerCounter.calls);
+	}
+	twk_shutdown();
+}
+
+// -------------------------------------------------------
+// a one line edit only re-applies the changed category
+// -------------------------------------------------------
+void incrementalReloadTest() {
+	const int num = 100000;
+	float* values = new float[num];
+	twk_init(&errorHandler);
+	char* text = buildScalingSettings(num, values);
+	PerfTimer timer;
+	timer.start();
+	twk_parse(text);
+	double full = timer.stop();
+	timer.start();
+	twk_parse(text);
+	double unchanged = timer.stop();
+	int categories[16];
+	Tweakable changed[16];
+	if (twk_get_changed_categories(categories, 16) != 0 || !twk_verify()) {
+		printf("ERROR - unchanged text reported changes\n");
+	}
+	// change the value of the middle item
+	char line[64];
+	char name[32];
+	buildName(name, "value_", (num / 2) % 100);
+	sprintf(line, "\t%s : %d.5\n", name, num / 2);
+	char* number = strstr(text, line) + strlen(line) - 4;
+	*number = '7';
+	timer.start();
+	twk_parse(text);
+	double edited = timer.stop();
+	int numCategories = twk_get_changed_categories(categories, 16);
+	int numChanged = twk_get_changed_tweakables(changed, 16);
+	if (numCategories != 1 || numChanged != 1 || changed[0].ptr.fPtr != &values[num / 2] || !twk_verify()) {
+		printf("ERROR - expected one change (%d categories %d items)\n", numCategories, numChanged);
+	}
+	else {
+		printf("changed: %s.%s = %g\n", twk_get_category_name(categories[0]), changed[0].name, *changed[0].ptr.fPtr);
+	}
+	printf("items: %d full: %.1f unchanged: %.1f one edit: %.1f microseconds\n", num, full, unchanged, edited);
+	// dropping a category reports its items as missing
+	char* last = strrchr(text, '{');
+	while (last > text && last[-1] != '\n') {
+		--last;
+	}
+	*last = '\0';
+	twk_parse(text);
+	if (twk_verify()) {
+		printf("ERROR - missing category not detected\n");
+	}
+	twk_shutdown();
+	delete[] text;
+	delete[] values;
+}
+
+// -------------------------------------------------------
+// bakes a large settings file and compares binding it with
+// parsing the text
+// -------------------------------------------------------
+void binaryTest() {
+	const int num = 100000;
+	float* values = new float[num];
+	twk_init(&errorHandler);
+	char* text = buildScalingSettings(num, values);
+	PerfTimer timer;
+	timer.start();
+	twk_parse(text);
+	double parsed = timer.stop();
+	timer.start();
+	size_t size = 0;
+	char* data = twk_bake_binary(text, &size);
+	double baked = timer.stop();
+	twk_shutdown();
+	twk_init(&errorHandler);
+	delete[] text;
+	text = buildScalingSettings(num, values);
+	for (int i = 0; i < num; ++i) {
+		values[i] = 0.0f;
+	}
+	timer.start();
+	bool ret = twk_load_binary(data, size);
+	double bound = timer.stop();
+	bool valid = ret && twk_verify();
+	for (int i = 0; i < num; ++i) {
+		valid = valid && values[i] == i + 0.5f;
+	}
+	if (!valid) {
+		printf("ERROR - binary values not valid\n");
+	}
+	printf("items: %d text: %d bytes binary: %d bytes parse: %.1f bake: %.1f load binary: %.1f microseconds\n", num, (int)strlen(text), (int)size, parsed, baked, bound);
+	twk_shutdown();
+	delete[] data;
+	delete[] text;
+	// the types are converted when binding
+	twk_init(&errorHandler);
+	data = twk_bake_binary("one {\n\tv : 1, 2\n\tc : 255, 0, 51, 255\n\ti : 7\n\tv : 3, 4\n}\n", &size);
+	ds::vec2 v(0, 0);
+	twk_add("one", "v", &v);
+	ds::Color c(0.0f, 0.0f, 0.0f, 0.0f);
+	twk_add("one", "c", &c);
+	int iv = 0;
+	twk_add("one", "i", &iv);
+	twk_load_binary(data, size);
+	if (v.x != 3.0f || v.y != 4.0f || c.r != 1.0f || c.b != 0.2f || iv != 7 || twk_num_categories() != 1) {
+		printf("ERROR - binary conversion\n");
+	}
+	data[0] = 'x';
+	if (twk_load_binary(data, size)) {
+		printf("ERROR - invalid binary accepted\n");
+	}
+	data[0] = 'T';
+	// other byte order and a blob that is not 8 byte aligned
+	uint32_t byteOrder = 0x04030201;
+	char* copy = new char[size + 8];
+	memcpy(copy, data, size);
+	memcpy(copy + 28, &byteOrder, sizeof(uint32_t));
+	bool swapped = twk_load_binary(copy, size);
+	memcpy(copy + 1, data, size);
+	if (swapped || twk_load_binary(copy + 1, size)) {
+		printf("ERROR - binary with wrong byte order or alignment accepted\n");
+	}
+	// seeds that point outside of the entries must not be followed
+	uint32_t count = 0;
+	uint32_t buckets = 0;
+	memcpy(&count, data + 8, sizeof(uint32_t));
+	memcpy(&buckets, data + 12, sizeof(uint32_t));
+	for (uint32_t b = 0; b < buckets; ++b) {
+		int32_t seed = b % 2 == 0 ? INT32_MIN : -static_cast<int32_t>(count) - 5;
+		memcpy(data + 32 + count * 16 + b * sizeof(int32_t), &seed, sizeof(int32_t));
+	}
+	iv = 0;
+	twk_load_binary(data, size);
+	if (iv != 0) {
+		printf("ERROR - corrupt binary seeds\n");
+	}
+	delete[] copy;
+	twk_shutdown();
+	delete[] data;
+	delete[] values;
+}
+
+struct SaveItem {
+	float f;
+	int i;
+	uint32_t u;
+	ds::vec2 v2;
+	ds::vec3 v3;
+	ds::vec4 v4;
+	ds::Color c;
+	float a[5];
+};
+
+void addSaveItems(TWKContext* ctx, SaveItem* items, int num) {
+	char category[32];
+	char name[32];
+	for (int i = 0; i < num; ++i) {
+		buildName(category, "cat_", i / 16);
+		buildName(name, "f_", i);
+		twk_add(ctx, category, name, &items[i].f);
+		buildName(name, "i_", i);
+		twk_add(ctx, category, name, &items[i].i);
+		buildName(name, "u_", i);
+		twk_add(ctx, category, name, &items[i].u);
+		buildName(name, "vec_a_", i);
+		twk_add(ctx, category, name, &items[i].v2);
+		buildName(name, "vec_b_", i);
+		twk_add(ctx, category, name, &items[i].v3);
+		buildName(name, "vec_c_", i);
+		twk_add(ctx, category, name, &items[i].v4);
+		buildName(name, "c_", i);
+		twk_add(ctx, category, name, &items[i].c);
+		buildName(name, "a_", i);
+		twk_add(ctx, category, name, items[i].a, 5);
+	}
+}
+
+float randomFloat(uint32_t* state) {
+	uint32_t bits = nextRandom(state) & 0xFF7FFFFF;
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+// -------------------------------------------------------
+// saving and loading the file again gives back every value
+// bit for bit - compares the throughput with fprintf %.9g
+// -------------------------------------------------------
+void saveTest() {
+	const int num = 12500;
+	const char* fileName = "save_test.txt";
+	uint32_t state = 0x2545F491;
+	SaveItem* items = new SaveItem[num];
+	SaveItem* loaded = new SaveItem[num];
+	float* values = &items[0].f;
+	float* loadedValues = &loaded[0].f;
+	for (size_t i = 0; i < num * sizeof(SaveItem) / sizeof(float); ++i) {
+		values[i] = randomFloat(&state);
+		loadedValues[i] = 0.0f;
+	}
+	for (int i = 0; i < num; ++i) {
+		// integers are parsed as floats
+		items[i].i = static_cast<int>(nextRandom(&state) % (1 << 25)) - (1 << 24);
+		items[i].u = nextRandom(&state) % (1 << 24);
+		// colors are divided by 255 when they are parsed
+		for (int j = 0; j < 4; ++j) {
+			float channel = j % 2 == 0 ? static_cast<float>(nextRandom(&state) % 256) : static_cast<float>(nextRandom(&state) % 25500) / 100.0f;
+			items[i].c.data[j] = channel / 255.0f;
+		}
+	}
+	TWKContext* source = twk_create(&errorHandler);
+	addSaveItems(source, items, num);
+	PerfTimer timer;
+	timer.start();
+	twk_save(source, fileName);
+	double save = timer.stop();
+	TWKContext* target = twk_create(fileName, &errorHandler);
+	addSaveItems(target, loaded, num);
+	twk_load(target);
+	if (memcmp(items, loaded, num * sizeof(SaveItem)) != 0 || !twk_verify(target)) {
+		for (size_t i = 0; i < num * sizeof(SaveItem) / sizeof(float); ++i) {
+			if (memcmp(&values[i], &loadedValues[i], sizeof(float)) != 0) {
+				printf("ERROR - value %d differs: %.9g / %.9g\n", (int)i, values[i], loadedValues[i]);
+				break;
+			}
+		}
+	}
+	FILE* fp = fopen(fileName, "rb");
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fclose(fp);
+	// the same values with fprintf
+	timer.start();
+	fp = fopen("save_test_printf.txt", "w");
+	for (size_t i = 0; i < num * sizeof(SaveItem) / sizeof(float); ++i) {
+		fprintf(fp, "\tvalue : %.9g\n", values[i]);
+	}
+	fclose(fp);
+	double reference = timer.stop();
+	printf("items: %d size: %d bytes twk_save: %.1f microseconds (%.1f MB/s) fprintf: %.1f microseconds\n", num * 8, (int)size, save, size / save, reference);
+	twk_destroy(source);
+	twk_destroy(target);
+	remove(fileName);
+	remove("save_test_printf.txt");
+	delete[] items;
+	delete[] loaded;
+}
+
+// -------------------------------------------------------
+// compares twk_load (buffered or with TWK_USE_MMAP mapped)
+// against reading the whole file into a heap copy and
+// parsing it. Reports the measured times and the bytes the
+// load allocated.
+// -------------------------------------------------------
+void mappedLoadTest() {
+	const char* fileName = "mapped_test.json";
+	const int num = 200000;
+	float* values = new float[num];
+	twk_init(fileName, &errorHandler);
+	char* text = buildScalingSettings(num, values);
+	writeTextFile(fileName, text);
+	size_t size = strlen(text);
+	TwkAllocationStats before;
+	twk_get_allocation_stats(&before);
+	PerfTimer timer;
+	timer.start();
+	twk_load();
+	double loaded = timer.stop();
+	TwkAllocationStats after;
+	twk_get_allocation_stats(&after);
+	if (!twk_verify() || values[num - 1] != (num - 1) + 0.5f) {
+		printf("ERROR - not valid\n");
+	}
+	twk_shutdown();
+	// same file read into a heap copy with a new context
+	twk_init(&errorHandler);
+	delete[] text;
+	text = buildScalingSettings(num, values);
+	timer.start();
+	FILE* fp = fopen(fileName, "r");
+	char* copy = new char[size + 1];
+	size_t read = fread(copy, 1, size, fp);
+	copy[read] = '\0';
+	fclose(fp);
+	twk_parse(copy);
+	delete[] copy;
+	double buffered = timer.stop();
+#ifdef TWK_USE_MMAP
+	const char* mode = "mapped";
+#else
+	const char* mode = "buffered";
+#endif
+	printf("file: %d bytes twk_load (%s): %.1f microseconds %d bytes allocated, heap copy: %.1f microseconds\n", (int)size, mode, loaded, (int)(after.bytesInUse - before.bytesInUse), buffered);
+	twk_shutdown();
+	remove(fileName);
+	delete[] text;
+	delete[] values;
+}
+
+// -------------------------------------------------------
+// many readers and one writer - every reader checks that
+// the vec3 and the array always come from the same reload
+// -------------------------------------------------------
+struct SnapshotReader {
+	int reads;
+	int errors;
+	double averageNs;
+	double maxNs;
+};
+
+void snapshotReader(TwkSnapshotRef vRef, TwkSnapshotRef arRef, std::atomic<bool>* running, SnapshotReader* result) {
+	result->reads = 0;
+	result->errors = 0;
+	result->maxNs = 0.0;
+	double total = 0.0;
+	while (running->load()) {
+		ds::vec3 v;
+		float ar[16];
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		uint32_t seq;
+		do {
+			seq = twk_snapshot_begin();
+			twk_snapshot_load(vRef, &v);
+			twk_snapshot_load(arRef, ar);
+		} while (twk_snapshot_retry(seq));
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		total += ns;
+		if (ns > result->maxNs) {
+			result->maxNs = ns;
+		}
+		bool valid = v.x == v.y && v.y == v.z;
+		for (int i = 0; i < 16; ++i) {
+			valid = valid && ar[i] == v.x;
+		}
+		if (!valid) {
+			++result->errors;
+		}
+		++result->reads;
+	}
+	result->averageNs = result->reads > 0 ? total / result->reads : 0.0;
+}
+
+void snapshotTest() {
+	const int numReaders = 8;
+	const int numWrites = 20000;
+	twk_init(&errorHandler);
+	ds::vec3 v(0, 0, 0);
+	twk_add("snap", "v", &v);
+	float ar[16] = { 0 };
+	twk_add("snap", "ar", ar, 16);
+	twk_enable_snapshots();
+	TwkSnapshotRef vRef = twk_snapshot_ref("snap", "v");
+	TwkSnapshotRef arRef = twk_snapshot_ref("snap", "ar");
+	if (vRef.offset == -1 || arRef.offset == -1) {
+		printf("ERROR - no snapshot reference\n");
+	}
+	std::atomic<bool> running(true);
+	SnapshotReader results[numReaders];
+	std::thread* readers[numReaders];
+	for (int i = 0; i < numReaders; ++i) {
+		readers[i] = new std::thread(snapshotReader, vRef, arRef, &running, &results[i]);
+	}
+	char text[1024];
+	for (int i = 1; i <= numWrites; ++i) {
+		int l = sprintf(text, "snap {\n\tv : %d, %d, %d\n\tar : %d", i, i, i, i);
+		for (int j = 1; j < 16; ++j) {
+			l += sprintf(text + l, ", %d", i);
+		}
+		strcpy(text + l, "\n}\n");
+		twk_parse(text);
+	}
+	running.store(false);
+	int reads = 0;
+	int errors = 0;
+	double average = 0.0;
+	double maxNs = 0.0;
+	for (int i = 0; i < numReaders; ++i) {
+		readers[i]->join();
+		delete readers[i];
+		reads += results[i].reads;
+		errors += results[i].errors;
+		average += results[i].averageNs * results[i].reads;
+		if (results[i].maxNs > maxNs) {
+			maxNs = results[i].maxNs;
+		}
+	}
+	ds::vec3 last;
+	twk_snapshot_read(vRef, &last);
+	if (errors != 0 || last.x != static_cast<float>(numWrites)) {
+		printf("ERROR - %d inconsistent reads\n", errors);
+	}
+	printf("readers: %d writes: %d reads: %d avg: %.1f ns max: %.1f ns\n", numReaders, numWrites, reads, reads > 0 ? average / reads : 0.0, maxNs);
+	twk_shutdown();
+}
+
 void basicTest() {
 	PerfTimer timer;
 	twk_init("..\\test\\basic_settings.json", &errorHandler);
@@ -80,7 +1601,8 @@ void basicTest() {
 	float none = 200.0f;
 	twk_add("test", "none", &none);
 	timer.start();
-	while (1 < 2) {
+	// edit the file within the next five seconds to see the reload
+	for (int frame = 0; frame < 25; ++frame) {
 		if (twk_load()) {
 			double elapsed = timer.stop();
 			printf("elapsed: %3.6f microseconds\n", elapsed);
@@ -102,13 +1624,228 @@ void basicTest() {
 				printf("NO TT FOUND!!!\n");
 			}
 		}
-		Sleep(200);
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	}
+	twk_shutdown();
+}
+
+
+
+// -------------------------------------------------------
+// independent contexts - parsing one settings file per
+// context one after another and on one thread each
+// -------------------------------------------------------
+void parseContexts(TWKContext** contexts, char** texts, int count, bool threaded) {
+	std::thread threads[8];
+	for (int c = 0; c < count; ++c) {
+		if (threaded) {
+			threads[c] = std::thread(static_cast<void(*)(TWKContext*, const char*)>(twk_parse), contexts[c], texts[c]);
+		}
+		else {
+			twk_parse(contexts[c], texts[c]);
+		}
+	}
+	for (int c = 0; c < count && threaded; ++c) {
+		threads[c].join();
+	}
+}
+
+void contextTest() {
+	const int count = 4;
+	const int num = 50000;
+	TWKContext* contexts[2][count];
+	float* values[2][count];
+	char* texts[2][count];
+	for (int r = 0; r < 2; ++r) {
+		for (int c = 0; c < count; ++c) {
+			contexts[r][c] = twk_create(&errorHandler);
+			values[r][c] = new float[num];
+			texts[r][c] = buildScalingSettings(num, values[r][c], contexts[r][c]);
+		}
+	}
+	// the first value of the first context differs
+	texts[0][0][strlen("cat_a {\n\tvalue_a : ")] = '7';
+	texts[1][0][strlen("cat_a {\n\tvalue_a : ")] = '7';
+	PerfTimer timer;
+	timer.start();
+	parseContexts(contexts[0], texts[0], count, false);
+	double sequential = timer.stop();
+	timer.start();
+	parseContexts(contexts[1], texts[1], count, true);
+	double threaded = timer.stop();
+	twk_init();
+	float v = 0.0f;
+	if (twk_get("cat_a", "value_a", &v)) {
+		printf("ERROR - default context sees other contexts\n");
+	}
+	for (int r = 0; r < 2; ++r) {
+		for (int c = 0; c < count; ++c) {
+			twk_get(contexts[r][c], "cat_a", "value_a", &v);
+			if (!twk_verify(contexts[r][c]) || v != (c == 0 ? 7.5f : 0.5f) || values[r][c][num - 1] != num - 0.5f) {
+				printf("ERROR - context %d / %d: %g\n", r, c, v);
+			}
+			twk_destroy(contexts[r][c]);
+			delete[] values[r][c];
+			delete[] texts[r][c];
+		}
 	}
 	twk_shutdown();
+	printf("contexts: %d items: %d sequential: %.1f threaded: %.1f microseconds\n", count, num, sequential, threaded);
+}
+
+// -------------------------------------------------------
+// fixed arena - after the first load reloading the text,
+// the file and the baked binary allocates nothing
+// -------------------------------------------------------
+void allocationTest() {
+	const int num = 10000;
+	const size_t capacity = 16 * 1024 * 1024;
+	char* memory = new char[capacity];
+	float* values = new float[num];
+	const char* fileName = "alloc_test.txt";
+	TwkAllocator allocator = twk_arena_allocator(memory, capacity);
+	twk_init(fileName, allocator, &errorHandler);
+	char* text = buildScalingSettings(num, values);
+	// the first load has to change every value to size the queues
+	memset(values, 0, num * sizeof(float));
+	writeTextFile(fileName, text);
+	CallbackCounter counter = { 0, "" };
+	twk_on_change("cat_a", countChange, &counter);
+	twk_enable_snapshots();
+	size_t size = 0;
+	char* binary = twk_bake_binary(text, &size);
+	// a second context reloads a set of files loaded by twk_load_many
+	TWKContext* many = twk_create(&errorHandler);
+	float manyValue = 0.0f;
+	twk_add(many, "cat_a", "value_a", &manyValue);
+	const char* manyFiles[] = { "alloc_many_a.txt", "alloc_many_b.txt" };
+	writeTextFile(manyFiles[0], text);
+	writeTextFile(manyFiles[1], "other {\n\tvalue : 1\n}\n");
+	// first load of every path
+	twk_load();
+	twk_parse(text);
+	twk_load_binary(binary, size);
+	twk_load_many(many, manyFiles, 2);
+	TwkAllocationStats before;
+	twk_get_allocation_stats(&before);
+	for (int i = 0; i < 10; ++i) {
+		// every reload changes the first value of cat_a
+		text[strlen("cat_a {\n\tvalue_a : ")] = '1' + i % 9;
+		twk_parse(text);
+		twk_load_binary(binary, size);
+		writeTextFile(fileName, text);
+		for (int j = 0; j < 100 && !twk_load(); ++j) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		writeTextFile(manyFiles[0], text);
+		for (int j = 0; j < 100 && !twk_load(many); ++j) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+	TwkAllocationStats after;
+	twk_get_allocation_stats(&after);
+	if (after.allocations != before.allocations || after.heapFallbacks != 0 || counter.calls < 20 || manyValue != values[0]) {
+		printf("ERROR - steady state allocated %d blocks (%d callbacks)\n", (int)(after.allocations - before.allocations), counter.calls);
+	}
+	printf("allocations: %d peak: %d bytes steady state allocations: %d\n", (int)after.allocations, (int)after.peakBytes, (int)(after.allocations - before.allocations));
+	twk_destroy(many);
+	twk_shutdown();
+	twk_get_allocation_stats(&after);
+	if (after.bytesInUse != 0) {
+		printf("ERROR - %d bytes still in use\n", (int)after.bytesInUse);
+	}
+	delete[] binary;
+	delete[] text;
+	delete[] values;
+	delete[] memory;
+	remove(fileName);
+	remove(manyFiles[0]);
+	remove(manyFiles[1]);
 }
 
 
 
+// -------------------------------------------------------
+// reload counters, histograms and the trace export
+// -------------------------------------------------------
+void statsTest() {
+	TWKContext* ctx = twk_create(&errorHandler);
+	float a = 0.0f;
+	ds::vec2 b(0, 0);
+	twk_add(ctx, "stats", "a", &a);
+	twk_add(ctx, "stats", "b", &b);
+	twk_enable_trace(ctx, 64);
+	// c is not registered
+	const char* text = "stats {\n\ta : 1\n\tb : 2, 3\n\tc : 4\n}\n";
+	twk_parse(ctx, text);
+	TwkStats stats = twk_stats(ctx);
+	if (stats.reloads != 1 || stats.last.bytesRead != strlen(text) || stats.last.tokens != 14 || stats.last.keysApplied != 2
+		|| stats.last.lookupMisses != 1 || stats.last.lookupProbes < 3 || stats.total.count != 1 || stats.last.totalTime < stats.last.parseTime) {
+		printf("ERROR - parse stats: %d %d %d %d %d\n", stats.reloads, (int)stats.last.bytesRead, stats.last.tokens, stats.last.keysApplied, stats.last.lookupMisses);
+	}
+	// the unchanged block is skipped
+	twk_parse(ctx, text);
+	stats = twk_stats(ctx);
+	if (stats.reloads != 2 || stats.last.keysApplied != 0 || stats.last.tokens >= 14) {
+		printf("ERROR - unchanged parse stats: %d %d\n", stats.last.keysApplied, stats.last.tokens);
+	}
+	twk_destroy(ctx);
+	ctx = twk_create(&errorHandler);
+	twk_add(ctx, "stats", "a", &a);
+	twk_add(ctx, "stats", "b", &b);
+	twk_enable_trace(ctx, 64);
+	writeTextFile("stats_a.txt", "stats {\n\ta : 5\n}\n");
+	writeTextFile("stats_b.txt", "stats {\n\tb : 6, 7\n}\n");
+	const char* files[] = { "stats_a.txt", "stats_b.txt" };
+	twk_load_many(ctx, files, 2);
+	stats = twk_stats(ctx);
+	if (stats.reloads != 1 || stats.last.keysApplied != 2 || stats.last.bytesRead != 37 || a != 5.0f || b.y != 7.0f) {
+		printf("ERROR - load many stats: %d %d\n", stats.last.keysApplied, (int)stats.last.bytesRead);
+	}
+	if (!twk_write_trace(ctx, "stats_trace.json")) {
+		printf("ERROR - cannot write trace\n");
+	}
+	char buffer[4096];
+	memset(buffer, 0, sizeof(buffer));
+	FILE* fp = fopen("stats_trace.json", "r");
+	if (fp) {
+		fread(buffer, 1, sizeof(buffer) - 1, fp);
+		fclose(fp);
+	}
+	// load and parse of both files, apply and the whole reload
+	int events = 0;
+	for (const char* c = strstr(buffer, "\"ph\""); c != 0; c = strstr(c + 1, "\"ph\"")) {
+		++events;
+	}
+	if (strncmp(buffer, "{\"traceEvents\":[", 16) != 0 || strstr(buffer, "twk_load_many") == 0 || strstr(buffer, "stats_b.txt") == 0 || events != 6) {
+		printf("ERROR - trace (%d events):\n%s\n", events, buffer);
+	}
+	// only the last events are kept
+	twk_enable_trace(ctx, 2);
+	twk_parse(ctx, text);
+	twk_parse(ctx, text);
+	twk_write_trace(ctx, "stats_trace.json");
+	memset(buffer, 0, sizeof(buffer));
+	fp = fopen("stats_trace.json", "r");
+	if (fp) {
+		fread(buffer, 1, sizeof(buffer) - 1, fp);
+		fclose(fp);
+	}
+	events = 0;
+	for (const char* c = strstr(buffer, "\"ph\""); c != 0; c = strstr(c + 1, "\"ph\"")) {
+		++events;
+	}
+	if (events != 2 || strstr(buffer, "\"twk_parse\"") == 0) {
+		printf("ERROR - trace ring buffer (%d events):\n%s\n", events, buffer);
+	}
+	stats = twk_stats(ctx);
+	printf("reloads: %d last: %.1f parse: %.1f apply: %.1f microseconds\n", stats.reloads, stats.last.totalTime, stats.last.parseTime, stats.last.applyTime);
+	twk_destroy(ctx);
+	remove("stats_a.txt");
+	remove("stats_b.txt");
+	remove("stats_trace.json");
+}
+
 int main() {
 	
 	//timingTest();
@@ -117,6 +1854,56 @@ int main() {
 	
 	//basicTest();
 
+	//reloadScalingTest();
+
+	//parserTest();
+
+	//simdTest();
+
+	//floatParsingTest();
+
+	//saveTest();
+
+	//watchTest();
+
+	//backgroundReloadTest();
+
+	//snapshotTest();
+
+	//mappedLoadTest();
+
+	//binaryTest();
+
+	//incrementalReloadTest();
+
+	//callbackTest();
+
+	//keyTest();
+
+	//poolTest();
+
+	//curveTest();
+
+	//derivedTest();
+
+	//handleTest();
+
+	//structTest();
+
+	//itemStoreTest();
+
+	//stringArenaTest();
+
+	//allocationTest();
+
+	//contextTest();
+
+	//includeTest();
+
+	//loadManyTest();
+
+	//statsTest();
+
 	categoryTest();
 
     return 0;
@@ -0,0 +1,43 @@
+// -------------------------------------------------------
+// twk_bake - compiles a settings file into the binary
+// format read by twk_load_binary
+//
+// usage: twk_bake <settings.json> <settings.twkb>
+// -------------------------------------------------------
+#define GAMESETTINGS_IMPLEMENTATION
+#include "../ds_tweakable.h"
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		printf("usage: twk_bake <settings.json> <settings.twkb>\n");
+		return 1;
+	}
+	FILE* fp = fopen(argv[1], "rb");
+	if (fp == 0) {
+		printf("Cannot load file: '%s'\n", argv[1]);
+		return 1;
+	}
+	fseek(fp, 0, SEEK_END);
+	long sz = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	char* text = new char[sz + 1];
+	size_t read = fread(text, 1, sz, fp);
+	text[read] = '\0';
+	fclose(fp);
+	size_t size = 0;
+	char* data = twk_bake_binary(text, &size);
+	delete[] text;
+	fp = fopen(argv[2], "wb");
+	if (fp == 0 || fwrite(data, 1, size, fp) != size) {
+		printf("Cannot write file: '%s'\n", argv[2]);
+		if (fp != 0) {
+			fclose(fp);
+		}
+		delete[] data;
+		return 1;
+	}
+	fclose(fp);
+	delete[] data;
+	printf("%s -> %s (%d bytes)\n", argv[1], argv[2], (int)size);
+	return 0;
+}